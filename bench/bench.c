@@ -0,0 +1,520 @@
+#if !defined(_WIN32)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include "../src/CJPath.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+/**
+	This file contains the benchmark. The corpora are generated, each path is evaluated by the entry points of the
+	corpus for the minimal time and the measurements are printed as one JSON object per line. With --baseline the
+	previous output is compared and the slower queries are reported as regressions.
+*/
+
+#define DEFAULT_MIN_TIME 0.2
+#define DEFAULT_THRESHOLD 10.0
+#define MAX_PATHS 12
+#define MAX_NAME 64
+#define MAX_PATH 128
+#define MAX_API 16
+
+// Entry points measured for the corpus
+#define API_DOC_INDEX_BUILD 0x00 // CJPathBuildDocIndex, measured once for the corpus with API_DOC_INDEX
+#define API_EVALUATE 0x01 // CJPathEvaluateArray with the compiled path
+#define API_PROCESSING 0x02 // CJPathProcessingArray, the path is compiled by each query
+#define API_DOC_INDEX 0x04 // CJPathEvaluateDocIndex over the index built once, the build is measured separately
+#define API_PARALLEL 0x08 // CJPathEvaluateParallel
+#define API_BATCH 0x10 // CJPathEvaluateBatch over the records of the corpus
+#define API_COUNT 5
+
+static const char* apiNames[API_COUNT] = { "evaluate", "processing", "docindex", "parallel", "batch" };
+
+typedef struct
+{
+	char* data;
+	size_t len;
+	size_t capacity;
+} Buffer;
+
+typedef struct
+{
+	const char* name;
+	void (*generate)(Buffer* buffer);
+	unsigned apis;
+	const char* paths[MAX_PATHS];
+} Corpus;
+
+typedef struct
+{
+	unsigned api;
+	const Buffer* buffer;
+	const char* path;
+	const CJPathCompiled* compiled;
+	const CJPathDocIndex* docIndex;
+	size_t threadCount;
+	CJPathArray results;
+	CJPathBatch batch;
+} Query;
+
+// Allocations made by the evaluation
+static size_t allocCount;
+static size_t allocBytes;
+
+static void* countingAlloc(size_t size)
+{
+	++allocCount;
+	allocBytes += size;
+	return malloc(size);
+}
+
+static void countingFree(void* ptr)
+{
+	free(ptr);
+}
+
+static double nowSeconds(void)
+{
+#if defined(_WIN32)
+	LARGE_INTEGER frequency, counter;
+
+	QueryPerformanceFrequency(&frequency);
+	QueryPerformanceCounter(&counter);
+	return (double)counter.QuadPart / (double)frequency.QuadPart;
+#else
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+#endif
+}
+
+static void append(Buffer* buffer, const char* format, ...)
+{
+	va_list args;
+	int len;
+
+	while (1)
+	{
+		va_start(args, format);
+		len = vsnprintf(buffer->data + buffer->len, buffer->capacity - buffer->len, format, args);
+		va_end(args);
+
+		if (len < 0)
+			exit(1);
+
+		if (buffer->len + (size_t)len < buffer->capacity)
+			break;
+
+		buffer->capacity = (buffer->capacity + (size_t)len) * 2;
+		buffer->data = (char*)realloc(buffer->data, buffer->capacity);
+		if (buffer->data == NULL)
+			exit(1);
+	}
+
+	buffer->len += (size_t)len;
+}
+
+// One message of a queue (about 300 bytes)
+static void generateSmall(Buffer* buffer)
+{
+	append(buffer, "{\"header\":{\"id\":\"7f3a9c\",\"ts\":1690000000,\"type\":\"order\"},\"body\":{\"status\":\"open\",\"items\":[");
+	append(buffer, "{\"sku\":\"A-100\",\"qty\":2,\"price\":9.99},{\"sku\":\"B-200\",\"qty\":1,\"price\":24.5},");
+	append(buffer, "{\"sku\":\"C-300\",\"qty\":5,\"price\":1.25}],\"customer\":{\"id\":42,\"name\":\"John Smith\"}}}");
+}
+
+// Queue messages, one per line (NDJSON)
+static void generateRecords(Buffer* buffer)
+{
+	size_t i;
+
+	for (i = 0; i < 10000; ++i)
+	{
+		append(buffer, "{\"header\":{\"id\":\"%06lx\",\"ts\":%lu,\"type\":\"%s\"},\"body\":{\"status\":\"open\",\"items\":["
+			"{\"sku\":\"A-%lu\",\"qty\":%lu,\"price\":9.99},{\"sku\":\"B-200\",\"qty\":1,\"price\":24.5}],"
+			"\"customer\":{\"id\":%lu,\"name\":\"John Smith\"}}}\n", (unsigned long)i, 1690000000UL + i,
+			(i % 4 == 0) ? "refund" : "order", (unsigned long)(i % 1000), (unsigned long)(i % 5), (unsigned long)(i % 700));
+	}
+}
+
+// Search result of the social network (twitter.json-like)
+static void generateTwitter(Buffer* buffer)
+{
+	size_t i;
+
+	append(buffer, "{\"statuses\":[");
+	for (i = 0; i < 2000; ++i)
+	{
+		append(buffer, "%s{\"id\":%llu,\"created_at\":\"Sun Aug 31 00:29:15 +0000 2014\",\"text\":\"Status number %lu with "
+			"some text, a link https://t.co/%lu and a \\\"quote\\\"\",\"user\":{\"id\":%lu,\"name\":\"User %lu\","
+			"\"screen_name\":\"user_%lu\",\"followers_count\":%lu,\"verified\":%s},\"entities\":{\"hashtags\":"
+			"[{\"text\":\"tag%lu\",\"indices\":[0,5]}],\"urls\":[],\"user_mentions\":[]},\"retweet_count\":%lu,"
+			"\"favorited\":false,\"lang\":\"%s\"}",
+			i ? "," : "", 505874924095815681ULL + i, (unsigned long)i, (unsigned long)i, 1000UL + i % 300, (unsigned long)(i % 300),
+			(unsigned long)(i % 300), (unsigned long)(i * 37 % 10000), (i % 7 == 0) ? "true" : "false", (unsigned long)(i % 50),
+			(unsigned long)(i % 100), (i % 3 == 0) ? "ja" : "en");
+	}
+	append(buffer, "],\"search_metadata\":{\"count\":2000,\"completed_in\":0.087}}");
+}
+
+// Nested objects (1000 levels). The descendant walk skipped each level again for every open level, $..leaf took
+// about 37 ms per query (0.6 MB/s). Past 8 levels the walk uses the structural index: about 1 ms (20 MB/s).
+static void generateDeep(Buffer* buffer)
+{
+	size_t i;
+
+	for (i = 0; i < 1000; ++i)
+		append(buffer, "{\"level\":%lu,\"next\":", (unsigned long)i);
+	append(buffer, "{\"level\":1000,\"leaf\":true}");
+	for (i = 0; i < 1000; ++i)
+		append(buffer, "}");
+}
+
+// Flat array of one million numbers
+static void generateFlat(Buffer* buffer)
+{
+	size_t i;
+
+	append(buffer, "{\"values\":[");
+	for (i = 0; i < 1000000; ++i)
+		append(buffer, "%s%lu", i ? "," : "", (unsigned long)(i * 7919 % 100000));
+	append(buffer, "],\"count\":1000000}");
+}
+
+// Long strings with escapes
+static void generateStrings(Buffer* buffer)
+{
+	size_t i, j;
+
+	append(buffer, "{\"documents\":[");
+	for (i = 0; i < 1000; ++i)
+	{
+		append(buffer, "%s{\"id\":%lu,\"body\":\"", i ? "," : "", (unsigned long)i);
+		for (j = 0; j < 16; ++j)
+			append(buffer, "Line %lu: \\\"quoted\\\" text, back\\\\slash, caf\\u00e9 and {braces} [brackets]\\n", (unsigned long)j);
+		append(buffer, "\"}");
+	}
+	append(buffer, "]}");
+}
+
+static const Corpus corpora[] =
+{
+	{ "small", &generateSmall, API_EVALUATE | API_PROCESSING | API_DOC_INDEX, { "$.header.id", "$['body']['status']",
+		"$.body['status','customer']", "$.header.*", "$.body.items[1].sku", "$.body.items[0:2].price", "$.body.items[*].qty",
+		"$..price", "$.body.items[?(@.qty > 1)].sku", "$.body.items[-1]", NULL } },
+	{ "records", &generateRecords, API_BATCH, { "$.header.id", "$.body['status','customer']", "$.header.*",
+		"$.body.items[*].qty", "$..price", "$.body.items[?(@.qty > 1)].sku", NULL } },
+	{ "twitter", &generateTwitter, API_EVALUATE | API_PROCESSING | API_DOC_INDEX | API_PARALLEL, { "$.search_metadata.count",
+		"$.statuses[1999].id", "$.statuses[10:20].user.name", "$.statuses[*].user.screen_name", "$.statuses[*].user['id','name']",
+		"$.statuses[*].entities.*", "$..hashtags[0].text", "$.statuses[?(@.lang == 'ja')].id", "$.statuses[-1].id", NULL } },
+	{ "deep", &generateDeep, API_EVALUATE | API_PROCESSING | API_DOC_INDEX, { "$.next.next.next.level", "$.next.next.*",
+		"$..leaf", "$..level", NULL } },
+	{ "flat", &generateFlat, API_EVALUATE | API_PROCESSING | API_DOC_INDEX | API_PARALLEL, { "$.count", "$['count','values']",
+		"$.*", "$.values[999999]", "$.values[1000:2000]", "$.values[*]", "$.values[-1]", "$.values[-100:]", NULL } },
+	{ "strings", &generateStrings, API_EVALUATE | API_PROCESSING | API_DOC_INDEX, { "$.documents[999].id",
+		"$.documents[*].body", "$.documents[0].*", "$..id", NULL } },
+};
+
+typedef struct
+{
+	char corpus[MAX_NAME];
+	char path[MAX_PATH];
+	char api[MAX_API];
+	double nsPerQuery;
+} BaselineEntry;
+
+// Reads the previous output, the lines that are not measurements are skipped
+static BaselineEntry* readBaseline(const char* fileName, size_t* count)
+{
+	FILE* file;
+	BaselineEntry* entries;
+	BaselineEntry entry;
+	char line[1024];
+	const char* measure;
+	const char* api;
+	size_t capacity;
+
+	*count = 0;
+
+	file = fopen(fileName, "r");
+	if (file == NULL)
+		return NULL;
+
+	entries = NULL;
+	capacity = 0;
+
+	while (fgets(line, sizeof(line), file) != NULL)
+	{
+		measure = strstr(line, "\"ns_per_query\":");
+		if (measure == NULL || sscanf(line, "{\"corpus\":\"%63[^\"]\",\"path\":\"%127[^\"]\"", entry.corpus, entry.path) != 2
+			|| sscanf(measure, "\"ns_per_query\":%lf", &entry.nsPerQuery) != 1)
+			continue;
+
+		// The output without the entry point measured CJPathEvaluateArray only
+		api = strstr(line, "\"api\":\"");
+		if (api == NULL || sscanf(api, "\"api\":\"%15[^\"]\"", entry.api) != 1)
+			strcpy(entry.api, apiNames[0]);
+
+		if (*count == capacity)
+		{
+			capacity = capacity ? capacity * 2 : 64;
+			entries = (BaselineEntry*)realloc(entries, capacity * sizeof(BaselineEntry));
+			if (entries == NULL)
+				exit(1);
+		}
+
+		entries[(*count)++] = entry;
+	}
+
+	fclose(file);
+	return entries;
+}
+
+static const BaselineEntry* findBaseline(const BaselineEntry* entries, size_t count, const char* corpus, const char* path,
+	const char* api)
+{
+	size_t i;
+
+	for (i = 0; i < count; ++i)
+	{
+		if (strcmp(entries[i].corpus, corpus) == 0 && strcmp(entries[i].path, path) == 0 && strcmp(entries[i].api, api) == 0)
+			return &entries[i];
+	}
+
+	return NULL;
+}
+
+// Evaluates the path once by the entry point of the query, the results of the previous query are reused
+static CJPathStatus runQuery(Query* query, size_t* resultCount)
+{
+	CJPathStatus status;
+	CJPathList* list;
+	CJPathList* item;
+	CJPathDocIndex* docIndex;
+	// The counters of the allocations are not shared by the threads
+	MemAllocFunc memAllocFunc = (query->threadCount > 1) ? &malloc : &countingAlloc;
+	MemFreeFunc memFreeFunc = (query->threadCount > 1) ? &free : &countingFree;
+
+	query->results.count = 0;
+	*resultCount = 0;
+
+	switch (query->api)
+	{
+	case API_DOC_INDEX_BUILD:
+		status = CJPathBuildDocIndex(query->buffer->data, query->buffer->len, &docIndex, &countingAlloc, &countingFree);
+		CJPathFreeDocIndex(&docIndex, &countingFree);
+		break;
+	case API_EVALUATE:
+		status = CJPathEvaluateArray(query->buffer->data, query->buffer->len, query->compiled, &query->results,
+			&countingAlloc, &countingFree);
+		*resultCount = query->results.count;
+		break;
+	case API_PROCESSING:
+		status = CJPathProcessingArray(query->buffer->data, query->buffer->len, query->path, strlen(query->path),
+			&query->results, &countingAlloc, &countingFree);
+		*resultCount = query->results.count;
+		break;
+	case API_DOC_INDEX:
+		list = NULL;
+		status = CJPathEvaluateDocIndex(query->docIndex, query->compiled, &list, &countingAlloc, &countingFree);
+		for (item = list; item != NULL; item = item->next)
+			++*resultCount;
+		CJPathFreeList(&list, &countingFree);
+		break;
+	case API_PARALLEL:
+		status = CJPathEvaluateParallel(query->buffer->data, query->buffer->len, query->compiled, query->threadCount,
+			&query->results, memAllocFunc, memFreeFunc);
+		*resultCount = query->results.count;
+		break;
+	default:
+		status = CJPathEvaluateBatch(query->buffer->data, query->buffer->len, query->compiled, query->threadCount,
+			&query->batch, memAllocFunc, memFreeFunc);
+		*resultCount = query->batch.results.count;
+		break;
+	}
+
+	return status;
+}
+
+// Runs the query for the minimal time and prints the measurement, returns false for a regression
+static bool measure(Query* query, const char* corpus, const char* apiName, double minTime, double threshold,
+	const BaselineEntry* baseline, size_t baselineCount)
+{
+	CJPathStatus status;
+	const BaselineEntry* previous;
+	double start, elapsed, nsPerQuery;
+	size_t iterations, resultCount, allocs, bytes;
+
+	// Warm up, the result array keeps its capacity
+	runQuery(query, &resultCount);
+
+	allocCount = 0;
+	allocBytes = 0;
+	iterations = 0;
+	start = nowSeconds();
+
+	do
+	{
+		status = runQuery(query, &resultCount);
+		++iterations;
+		elapsed = nowSeconds() - start;
+	} while (elapsed < minTime);
+
+	allocs = allocCount;
+	bytes = allocBytes;
+	nsPerQuery = elapsed * 1e9 / (double)iterations;
+
+	printf("{\"corpus\":\"%s\",\"path\":\"%s\",\"api\":\"%s\",\"status\":%d,\"results\":%lu,\"bytes\":%lu,"
+		"\"iterations\":%lu,\"mb_per_s\":%.1f,\"ns_per_query\":%.1f,", corpus, query->path, apiName, status,
+		(unsigned long)resultCount, (unsigned long)query->buffer->len, (unsigned long)iterations,
+		(double)query->buffer->len * (double)iterations / elapsed / 1e6, nsPerQuery);
+	if (query->threadCount > 1 && (query->api == API_PARALLEL || query->api == API_BATCH))
+		printf("\"allocs_per_query\":null,\"alloc_bytes_per_query\":null}\n");
+	else
+		printf("\"allocs_per_query\":%.2f,\"alloc_bytes_per_query\":%.1f}\n", (double)allocs / (double)iterations,
+			(double)bytes / (double)iterations);
+
+	previous = findBaseline(baseline, baselineCount, corpus, query->path, apiName);
+	if (previous != NULL && nsPerQuery > previous->nsPerQuery * (1.0 + threshold / 100.0))
+	{
+		fprintf(stderr, "REGRESSION %s %s %s: %.1f ns -> %.1f ns\n", corpus, query->path, apiName, previous->nsPerQuery,
+			nsPerQuery);
+		return false;
+	}
+
+	return true;
+}
+
+static void usage(void)
+{
+	fprintf(stderr, "Usage: cjpath_bench [--time seconds] [--corpus name] [--baseline file] [--threshold percent] "
+		"[--threads count]\n");
+}
+
+int main(int argc, char** argv)
+{
+	CJPathStatus status;
+	CJPathCompiled* compiled;
+	CJPathDocIndex* docIndex;
+	Query query;
+	Buffer buffer = { 0 };
+	BaselineEntry* baseline;
+	const char* corpusFilter;
+	const char* baselineFile;
+	double minTime, threshold;
+	size_t baselineCount, i, j, api;
+	int ret, arg;
+
+	buffer.capacity = 4096;
+	buffer.data = (char*)malloc(buffer.capacity);
+	if (buffer.data == NULL)
+		return 1;
+
+	memset(&query, 0, sizeof(query));
+	query.buffer = &buffer;
+	query.threadCount = 1;
+
+	minTime = DEFAULT_MIN_TIME;
+	threshold = DEFAULT_THRESHOLD;
+	corpusFilter = NULL;
+	baselineFile = NULL;
+
+	for (arg = 1; arg < argc; ++arg)
+	{
+		if (strcmp(argv[arg], "--time") == 0 && arg + 1 < argc)
+			minTime = atof(argv[++arg]);
+		else if (strcmp(argv[arg], "--corpus") == 0 && arg + 1 < argc)
+			corpusFilter = argv[++arg];
+		else if (strcmp(argv[arg], "--baseline") == 0 && arg + 1 < argc)
+			baselineFile = argv[++arg];
+		else if (strcmp(argv[arg], "--threshold") == 0 && arg + 1 < argc)
+			threshold = atof(argv[++arg]);
+		else if (strcmp(argv[arg], "--threads") == 0 && arg + 1 < argc)
+			query.threadCount = (size_t)atoi(argv[++arg]);
+		else
+		{
+			usage();
+			return 2;
+		}
+	}
+
+	baseline = NULL;
+	baselineCount = 0;
+	if (baselineFile != NULL)
+	{
+		baseline = readBaseline(baselineFile, &baselineCount);
+		if (baseline == NULL)
+			fprintf(stderr, "Baseline %s is empty or cannot be read\n", baselineFile);
+	}
+
+	ret = 0;
+
+	for (i = 0; i < sizeof(corpora) / sizeof(corpora[0]); ++i)
+	{
+		if (corpusFilter != NULL && strcmp(corpusFilter, corpora[i].name) != 0)
+			continue;
+
+		buffer.len = 0;
+		corpora[i].generate(&buffer);
+
+		// The index is built once for the paths, its build is measured as the query without the path
+		docIndex = NULL;
+		if ((corpora[i].apis & API_DOC_INDEX) != 0)
+		{
+			status = CJPathBuildDocIndex(buffer.data, buffer.len, &docIndex, &malloc, &free);
+			if (status != SUCCESS)
+			{
+				fprintf(stderr, "Document index of %s is not built, status(%d)\n", corpora[i].name, status);
+				ret = 1;
+				continue;
+			}
+
+			query.api = API_DOC_INDEX_BUILD;
+			query.path = "";
+			if (!measure(&query, corpora[i].name, "docindex_build", minTime, threshold, baseline, baselineCount))
+				ret = 1;
+		}
+		query.docIndex = docIndex;
+
+		for (j = 0; corpora[i].paths[j] != NULL; ++j)
+		{
+			status = CJPathCompile(corpora[i].paths[j], strlen(corpora[i].paths[j]), &compiled, &malloc);
+			if (status != SUCCESS)
+			{
+				fprintf(stderr, "Path %s is not compiled, status(%d)\n", corpora[i].paths[j], status);
+				ret = 1;
+				continue;
+			}
+
+			query.path = corpora[i].paths[j];
+			query.compiled = compiled;
+
+			for (api = 0; api < API_COUNT; ++api)
+			{
+				query.api = 1u << api;
+				if ((corpora[i].apis & query.api) != 0
+					&& !measure(&query, corpora[i].name, apiNames[api], minTime, threshold, baseline, baselineCount))
+					ret = 1;
+			}
+
+			CJPathFreeCompiled(&compiled, &free);
+		}
+
+		CJPathFreeDocIndex(&docIndex, &free);
+	}
+
+	CJPathFreeArray(&query.results, &countingFree);
+	CJPathFreeBatch(&query.batch, &countingFree);
+	free(buffer.data);
+	free(baseline);
+
+	return ret;
+}
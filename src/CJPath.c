@@ -8,825 +8,1790 @@
 */
 
 #include "CJPath.h"
+#include "CJPath_internal.h"
 #include "CJPath_utils.h"
+#include "CJPath_structural.h"
+#include "CJPath_arena.h"
+#include "CJPath_stats.h"
 #include <stdlib.h>
 #include <string.h>
 
-#define RETURN_NEXT_PARSE(offset) return parsePath(jsonData, jsonDataLen, path + (offset), pathLen - (offset), resultList, memAllocFunc, memFreeFunc)
+// Results are added after the tail of the list
+typedef struct
+{
+	ResultSink sink;
+	CJPathList* head;
+	CJPathList* tail;
+	const CJPathAllocator* allocator;
+} ListSink;
+
+// Results are added to the end of the array
+typedef struct
+{
+	ResultSink sink;
+	CJPathArray* array;
+	const CJPathAllocator* allocator;
+} ArraySink;
 
-#define JSON_VALUE_TRUE      "true"
-#define JSON_VALUE_TRUE_LEN  (sizeof(JSON_VALUE_TRUE)-1)
+// Results are stored to the buffer provided by the caller, the rest are only counted
+typedef struct
+{
+	ResultSink sink;
+	CJPathResult* results;
+	size_t capacity;
+	size_t count;
+} BufferSink;
+
+// Results with their types are stored to the buffer provided by the caller, the rest are only counted
+typedef struct
+{
+	ResultSink sink;
+	CJPathTypedResult* results;
+	size_t capacity;
+	size_t count;
 
-#define JSON_VALUE_FALSE     "false"
-#define JSON_VALUE_FALSE_LEN (sizeof(JSON_VALUE_FALSE)-1)
+	// The text evaluation counts the children of the stored values, the document index gives them with the value
+	bool countChildren;
+} TypedBufferSink;
 
-#define JSON_VALUE_NULL      "null"
-#define JSON_VALUE_NULL_LEN  (sizeof(JSON_VALUE_NULL)-1)
+// Results are passed to the callback, nothing is stored
+typedef struct
+{
+	ResultSink sink;
+	CJPathResultCallback callback;
+	void* userData;
+} CallbackSink;
 
-static CJPathList* addResultToList(CJPathList** listPtr, CJPathResult* new, MemAllocFunc memAllocFunc)
+// Results are only counted
+typedef struct
 {
-	CJPathList* newItem;
+	ResultSink sink;
+	size_t count;
+} CountSink;
 
-	if (*listPtr == NULL)
-	{
-		*listPtr = memAllocFunc(sizeof(CJPathList));
-		if (*listPtr == NULL)
-			return NULL;
-		memset(*listPtr, 0, sizeof(CJPathList));
-	}
-	CJPathList* list = *listPtr;
+// Only the first result is stored, the evaluation is stopped
+typedef struct
+{
+	ResultSink sink;
+	CJPathResult* result;
+} FirstSink;
 
-	if (list->next == list->prev) // List is empty
-	{
-		// Fill data
-		memcpy(&(list->result), new, sizeof(list->result));
-		list->prev = list; // Set previous item
+#define DESCENT_INLINE_FRAMES CJPATH_BUFFER_MAX_DEPTH
 
-		return list;
-	}
-	else // List is not empty
-	{
-		while (list->next != NULL)
-			list = list->next;
+// Items kept on the stack by the selection from the end before the allocator is used
+#define TAIL_INLINE_ITEMS CJPATH_BUFFER_MAX_TAIL
 
-		// Allocate new item
-		newItem = memAllocFunc(sizeof(CJPathList));
-		if (newItem == NULL)
-			return NULL;
+// Open levels of the descendant walk scanned as text, the deeper levels use the structural index
+#define DESCENT_INDEX_DEPTH 8
+
+// Work memory of the evaluations which do not store the results, used past the stack limits above
+static const CJPathAllocator heapAllocator = { &malloc, &free, NULL };
+
+// Object or array whose children are being walked by the descendant step (..)
+typedef struct
+{
+	const char* start;
+	const char* ptr;
+	const char* end;
+} DescentFrame;
+
+// Evaluation state shared by all steps
+typedef struct
+{
+	const CJPathCompiled* compiled;
+	const CJPathStructuralIndex* structural;
+	ResultSink* sink;
+	size_t resultCount;
+
+	// Work stack of the descendant walk, the inline frames are used first.
+	// Without the allocator the nesting is limited by the inline frames.
+	const CJPathAllocator* allocator;
+	DescentFrame* frames;
+	size_t frameCount;
+	size_t frameCapacity;
+	DescentFrame inlineFrames[DESCENT_INLINE_FRAMES];
+
+	// Grown buffers kept by the context, NULL if they are released after the evaluation
+	struct _EvalScratch* scratch;
+} EvalContext;
+
+// Buffers of the evaluation kept by the context between the calls
+typedef struct _EvalScratch
+{
+	DescentFrame* frames;
+	size_t frameCapacity;
+	CJPathResult* tailItems;
+	size_t tailAllocated;
+	CJPathStructuralIndex* index;
+} EvalScratch;
+
+struct _CJPathContext
+{
+	CJPathAllocator allocator;
+	EvalScratch scratch;
 
-		// Add new item
-		list->next = newItem;
+	// Paths compiled by CJPathContextProcessing, the chunks are kept by the reset
+	CJPathArena pathArena;
 
-		// Set previous item
-		newItem->prev = list;
+	// Results of the last evaluation
+	CJPathArray results;
+};
+
+static CJPathStatus addResultToList(ResultSink* sink, const CJPathResult* new)
+{
+	ListSink* const list = (ListSink*)sink;
+	CJPathList* newItem;
 
-		// Set nullptr for next
-		newItem->next = NULL;
+	// Allocate new item
+	newItem = allocatorAlloc(list->allocator, sizeof(CJPathList));
+	if (newItem == NULL)
+		return BAD_ALLOC;
 
-		// Fill data
-		memcpy(&(newItem->result), new, sizeof(newItem->result));
+	// Fill data
+	memcpy(&(newItem->result), new, sizeof(newItem->result));
+	newItem->next = NULL;
 
-		return newItem;
+	if (list->tail == NULL) // List is empty
+	{
+		newItem->prev = newItem;
+		list->head = newItem;
+	}
+	else
+	{
+		newItem->prev = list->tail;
+		list->tail->next = newItem;
 	}
-}
 
-static bool charIsIntegerNum(const char value)
-{
-	return (value >= '0' && value <= '9');
+	list->tail = newItem;
+
+	return SUCCESS;
 }
 
-static bool getRange(const char* value, size_t maxLen, size_t* from, size_t* to)
+static CJPathStatus addResultToBuffer(ResultSink* sink, const CJPathResult* new)
 {
-	*from = (size_t)atoll(value);
+	BufferSink* const buffer = (BufferSink*)sink;
 
-	value = strnstr(":", value, maxLen);
-	if (value == NULL)
-		return false;
-	++value; // by pass :
+	if (buffer->count < buffer->capacity)
+		memcpy(buffer->results + buffer->count, new, sizeof(CJPathResult));
 
-	*to = (size_t)atoll(value);
+	++buffer->count;
 
-	return true;
+	return SUCCESS;
 }
 
-static bool isRange(const char* inputStr, size_t maxLen)
+// Number of members or items of the object or array, the nested values are skipped. 0 for other types.
+static size_t countChildren(const CJPathResult* value)
 {
-	bool found;
-	size_t i;
+	CJPathStatus status;
+	CJPathResult key, res;
+	const char* ptr;
+	const char* const end = value->strPtr + value->strLen;
+	size_t count;
 
-	for (i = 0, found = 0; i < maxLen; ++i)
+	if (value->strPtr[0] != '{' && value->strPtr[0] != '[')
+		return 0;
+
+	for (ptr = value->strPtr, count = 0; ptr != end && (ptr == value->strPtr || ptr[0] == ','); ++count)
 	{
-		if (found != true && inputStr[i] == ':')
-			found = true;
+		if (value->strPtr[0] == '{')
+			status = nextMember(NULL, &ptr, end, &key, &res);
+		else
+			status = nextArrayItem(NULL, &ptr, end, &res);
 
-		if (inputStr[i] == ']')
-		{
-			if (found == true)
-				return true;
+		if (status == NOT_FOUND)
 			break;
-		}
-
+		if (status != SUCCESS)
+			return CJPATH_COUNT_UNKNOWN;
 	}
 
-	return false;
+	return count;
 }
 
-static size_t getOffsetChildByDot(const char* inputStr, size_t maxLength)
+static CJPathStatus addTypedResultToBuffer(ResultSink* sink, const CJPathResult* new)
 {
-	size_t offset;
+	TypedBufferSink* const buffer = (TypedBufferSink*)sink;
+	CJPathTypedResult* typed;
 
-	for (offset = 0; offset < maxLength; ++offset)
+	if (buffer->count < buffer->capacity)
 	{
-		if (inputStr[offset] == '.'
-			|| inputStr[offset] == '['
-			|| inputStr[offset] == '\0')
-			return offset;
+		typed = &buffer->results[buffer->count];
+		typed->value = *new;
+		typed->type = CJPathResultType(new);
+		typed->childCount = buffer->countChildren ? countChildren(new) : sink->childCount;
 	}
 
-	return 0;
+	++buffer->count;
+
+	return SUCCESS;
 }
 
-static CJPathStatus getNumArrayValues(const char* inputStr, size_t maxLen, size_t** arr, size_t* countElements, MemAllocFunc memAllocFunc)
+static CJPathStatus addResultToCallback(ResultSink* sink, const CJPathResult* new)
 {
-	const char* ptr;
-	size_t i;
+	CallbackSink* const callback = (CallbackSink*)sink;
+	const CJPathStatus status = callback->callback(new, callback->userData);
 
-	// Calc numbers of elements
-	for (i = 0, *countElements = 0; ; ++i)
-	{
-		if (!(i < maxLen))
-		{
-			if (inputStr[i - 1] == ',') // last symbol is ,
-				return INVALID_JSON_PATH;
+	return (status == STOPPED) ? EVALUATION_STOPPED : status;
+}
 
-			break;
-		}
-		if (inputStr[i] == ',')
-			++(*countElements);
-	}
+static CJPathStatus countResult(ResultSink* sink, const CJPathResult* new)
+{
+	(void)new;
+	++((CountSink*)sink)->count;
 
-	++(*countElements);
+	return SUCCESS;
+}
 
-	*arr = NULL;
-	*arr = (size_t*)memAllocFunc((*countElements) * sizeof(size_t));
-	if (*arr == NULL)
-		return BAD_ALLOC;
+static CJPathStatus stopAtResult(ResultSink* sink, const CJPathResult* new)
+{
+	(void)sink;
+	(void)new;
 
-	for (i = 0, ptr = inputStr; i < *countElements; ++i)
-	{
-		(*arr)[i] = atoll(ptr);
-		ptr = strstr(ptr, ",");
-		if (ptr == NULL)
-			break;
-		ptr += 1;
-	}
+	return EVALUATION_STOPPED;
+}
 
-	return SUCCESS;
+static CJPathStatus addFirstResult(ResultSink* sink, const CJPathResult* new)
+{
+	memcpy(((FirstSink*)sink)->result, new, sizeof(CJPathResult));
+
+	return EVALUATION_STOPPED;
 }
 
-static CJPathStatus getStrArrayValues(const char* inputStr, size_t maxLen, CJPathResult** arr, size_t* countElements, MemAllocFunc memAllocFunc)
+CJPathStatus appendResultToArray(CJPathArray* array, const CJPathResult* result, const CJPathAllocator* allocator)
 {
-	size_t i;
-	const char* ptr;
-	const char* s1;
-	const char* s2;
+	CJPathResult* items;
+	size_t capacity;
 
-	// Calc numbers of elements
-	for (i = 0, *countElements = 0; ; ++i)
+	if (array->count == array->capacity)
 	{
-		if (!(i < maxLen))
-		{
-			if (inputStr[i - 1] == ',') // last symbol is ,
-				return INVALID_JSON_PATH;
+		capacity = (array->capacity != 0) ? array->capacity * 2 : 16;
 
-			break;
+		items = (CJPathResult*)allocatorAlloc(allocator, capacity * sizeof(CJPathResult));
+		if (items == NULL)
+			return BAD_ALLOC;
+
+		if (array->items != NULL)
+		{
+			memcpy(items, array->items, array->count * sizeof(CJPathResult));
+			allocatorFree(allocator, array->items);
 		}
-		if (inputStr[i] == ',')
-			++(*countElements);
+
+		array->items = items;
+		array->capacity = capacity;
 	}
 
-	++(*countElements);
+	memcpy(array->items + array->count, result, sizeof(CJPathResult));
+	++array->count;
 
-	*arr = NULL;
-	*arr = (CJPathResult*)memAllocFunc((*countElements) * sizeof(CJPathResult));
-	if (*arr == NULL)
-		return BAD_ALLOC;
+	return SUCCESS;
+}
+
+static CJPathStatus addResultToArray(ResultSink* sink, const CJPathResult* new)
+{
+	return appendResultToArray(((ArraySink*)sink)->array, new, ((ArraySink*)sink)->allocator);
+}
+
+static void addStep(CompileBuilder* builder, const CJPathStep* step)
+{
+	if (builder->steps != NULL)
+		memcpy(builder->steps + builder->stepCount, step, sizeof(*step));
+
+	++builder->stepCount;
+}
 
-	for (i = 0, ptr = inputStr; i < *countElements; ++i)
+const char* addChars(CompileBuilder* builder, const char* text, size_t textLen)
+{
+	char* ptr = NULL;
+
+	if (builder->steps != NULL)
 	{
-		s1 = strnstr("\'", ptr, maxLen);
-		if (s1 == NULL)
-			return SUCCESS;
-		++s1;
-		s2 = strnstr("\'", s1, maxLen - (s1 - inputStr - 1));
-		if (s2 == NULL)
-			return INVALID_JSON_PATH;
+		ptr = builder->chars + builder->charCount;
+		memcpy(ptr, text, textLen);
+	}
 
-		(*arr + i)->strPtr = s1;
-		(*arr + i)->strLen = s2 - s1;
+	builder->charCount += textLen;
+	return ptr;
+}
 
-		if (ptr == NULL)
-			break;
+void addName(CompileBuilder* builder, const char* name, size_t nameLen)
+{
+	const char* const ptr = addChars(builder, name, nameLen);
 
-		ptr = (s2 + 1);
+	if (builder->steps != NULL)
+	{
+		builder->names[builder->nameCount].strPtr = ptr;
+		builder->names[builder->nameCount].strLen = nameLen;
 	}
 
-	return SUCCESS;
+	++builder->nameCount;
 }
 
-// Processing path and extract result
-static CJPathStatus processingPath(const char* jsonPath, size_t jsonPathLen, const char* jsonData,
-	size_t jsonDataLen, CJPathResult* result, bool extractFirst, MemAllocFunc memAllocFunc, MemFreeFunc memFreeFunc)
+void addFilterTerm(CompileBuilder* builder, const CJPathFilterTerm* term)
 {
-	CJPathStatus status;
+	if (builder->steps != NULL)
+		memcpy(builder->terms + builder->termCount, term, sizeof(*term));
 
-	char* ptr;
-	char* ptrEnd;
-	char* buildName;
-	unsigned cnt1, cnt2;
-	size_t sz;
-	const char* const endOfFile = jsonData + jsonDataLen;
+	++builder->termCount;
+}
 
-	status = SUCCESS;
-	buildName = NULL;
+static void addIndex(CompileBuilder* builder, size_t value)
+{
+	if (builder->steps != NULL)
+		builder->indexes[builder->indexCount] = value;
 
-	// Build name with "
-	if (!extractFirst)
-	{
-		sz = 3;
+	++builder->indexCount;
+}
 
-		buildName = (char*)memAllocFunc(jsonPathLen + sz);
-		if (buildName == NULL)
-			return BAD_ALLOC;
+// Parses a non-negative number, returns false if there are no digits
+static bool parseIndex(const char** ptr, const char* end, size_t* value)
+{
+	const char* start;
 
-		ptr = strnstr("'", jsonPath, jsonPathLen);
-		if (ptr == NULL)
-			ptr = strnstr(".", jsonPath, jsonPathLen);
+	*ptr = skipSpaces(*ptr, end);
 
-		if (ptr == NULL)
-			ptr = strnstr("[", jsonPath, jsonPathLen);
+	for (start = *ptr, *value = 0; *ptr != end && charIsIntegerNum((*ptr)[0]); ++(*ptr))
+		*value = *value * 10 + (size_t)((*ptr)[0] - '0');
 
-		if (ptr == NULL)
-			sz += strlen(jsonPath);
-		else
-			sz += (ptr - jsonPath);
+	if (*ptr == start)
+		return false;
 
-		if (sz > jsonPathLen + 3)
-			sz = jsonPathLen + 3;
+	*ptr = skipSpaces(*ptr, end);
+	return true;
+}
 
-		buildName[0] = '"';
-		memcpy(buildName + 1, jsonPath, sz - 1);
-		buildName[sz - 2] = '"';
-		buildName[sz - 1] = '\0';
+// Parses an optionally negative number, returns false if there are no digits
+static bool parseSignedIndex(const char** ptr, const char* end, ptrdiff_t* value)
+{
+	const char* const start = skipSpaces(*ptr, end);
+	size_t magnitude;
+	bool negative;
 
-		// Find object
-		ptr = strnstr(buildName, jsonData, jsonDataLen);
-		if (ptr == NULL || ptr >= endOfFile)
-		{
-			status = NOT_FOUND;
-			goto EXIT;
-		}
+	*ptr = start;
+	negative = (*ptr != end && (*ptr)[0] == '-');
+	if (negative)
+		++(*ptr); // by pass -
 
-		// Find :
-		ptr = strstr(ptr, ":");
-		if (ptr == NULL || ptr >= endOfFile)
-		{
-			status = NOT_FOUND;
-			goto EXIT;
-		}
-	}
-	else
+	if (*ptr == end || !charIsIntegerNum((*ptr)[0]) || !parseIndex(ptr, end, &magnitude)
+		|| magnitude > PTRDIFF_MAX || (negative && magnitude == 0))
 	{
-		ptr = (char*)jsonData;
+		*ptr = start;
+		return false;
 	}
 
-	for (++ptr; ptr != endOfFile; ++ptr)
-	{
-		if (ptr[0] == '"' || ptr[0] == '{' || ptr[0] == '[' || charIsIntegerNum(ptr[0])
-			|| (strncmp(ptr, JSON_VALUE_TRUE, JSON_VALUE_TRUE_LEN) == 0)
-			|| (strncmp(ptr, JSON_VALUE_FALSE, JSON_VALUE_FALSE_LEN) == 0)
-			|| (strncmp(ptr, JSON_VALUE_NULL, JSON_VALUE_NULL_LEN) == 0))
-			break;
-	}
+	*value = negative ? -(ptrdiff_t)magnitude : (ptrdiff_t)magnitude;
+	return true;
+}
+
+// Finds ] closing the bracket, skipping quoted names
+static const char* findBracketEnd(const char* ptr, const char* end)
+{
+	bool quoted;
 
-	if (ptr >= endOfFile)
+	for (quoted = false; ptr != end; ++ptr)
 	{
-		status = NOT_FOUND;
-		goto EXIT;
+		if (ptr[0] == '\'')
+			quoted = !quoted;
+		else if (ptr[0] == ']' && !quoted)
+			return ptr;
 	}
 
-	result->strPtr = ptr;
+	return NULL;
+}
+
+// Bracket-notated children (example: 'name1', 'name2')
+static CJPathStatus compileNames(const char* ptr, const char* end, CompileBuilder* builder, CJPathStep* step)
+{
+	const char* nameEnd;
+
+	step->type = STEP_CHILD;
 
-	// Find end of string
-	if (ptr[0] == '"')
+	while (1)
 	{
-		for (ptrEnd = ptr + 1, cnt1 = 0, cnt2 = 0; ptrEnd != endOfFile; ++ptrEnd)
-		{
-			if (ptrEnd[0] == '\\')
-			{
-				for (++ptrEnd; ptrEnd != endOfFile; ++ptrEnd)
-				{
-					if (ptrEnd >= endOfFile)
-					{
-						status = INVALID_JSON;
-						goto EXIT;
-					}
-
-					if (ptrEnd[0] == '\\') {
-						ptrEnd += 2;
-						break;
-					}
-				}
-			}
-			else if (ptrEnd[0] == '\"')
-				break;
-		}
+		ptr = skipSpaces(ptr, end);
+		if (ptr == end || ptr[0] != '\'')
+			return INVALID_JSON_PATH;
+		++ptr; // by pass '
 
-		if (ptrEnd >= endOfFile)
-		{
-			status = INVALID_JSON;
-			goto EXIT;
-		}
+		nameEnd = strnchr('\'', ptr, (size_t)(end - ptr));
+		if (nameEnd == NULL)
+			return INVALID_JSON_PATH;
 
-		result->strLen = (size_t)(ptrEnd - ptr) + 1;
-	}
+		addName(builder, ptr, (size_t)(nameEnd - ptr));
+		++step->count;
 
-	// Find end of number
-	else if (charIsIntegerNum(ptr[0]))
-	{
-		for (++ptr, result->strLen = 1;
-			(charIsIntegerNum(ptr[0]) || ptr[0] == '.')
-			&& (ptr != endOfFile)
-			&& (!(ptr[0] == ']' || ptr[0] == '}' || ptr[0] == ' ' || ptr[0] == '\t' || ptr[0] == '\n' || ptr[0] == '\r'));
-			++ptr, ++result->strLen);
+		ptr = skipSpaces(nameEnd + 1, end);
+		if (ptr == end)
+			return SUCCESS;
 
-		if (ptr >= endOfFile || ptr[0] == '.')
-		{
-			result->strLen = 0;
-			status = INVALID_JSON;
-			goto EXIT;
-		}
+		if (ptr[0] != ',')
+			return INVALID_JSON_PATH;
+		++ptr; // by pass ,
 	}
+}
 
-	// Find end of object
-	else if (ptr[0] == '{')
-	{
-		for (ptrEnd = ptr, cnt1 = 0, cnt2 = 0; ptrEnd != endOfFile; ++ptrEnd)
-		{
+// Sorts the indexes and removes duplicates, the items are selected in the array order anyway
+static size_t sortIndexes(size_t* indexes, size_t count)
+{
+	size_t i, j, value;
 
-			if (ptrEnd[0] == '{')
-				++cnt1;
+	for (i = 1; i < count; ++i)
+	{
+		for (value = indexes[i], j = i; j != 0 && indexes[j - 1] > value; --j)
+			indexes[j] = indexes[j - 1];
+		indexes[j] = value;
+	}
 
-			if (ptrEnd[0] == '}')
-				++cnt2;
+	for (i = 1, j = 1; i < count; ++i)
+	{
+		if (indexes[i] != indexes[j - 1])
+			indexes[j++] = indexes[i];
+	}
 
-			if (cnt1 == cnt2)
-				break;
-		}
+	return (count != 0) ? j : 0;
+}
 
-		if (ptrEnd >= endOfFile)
-		{
-			status = INVALID_JSON;
-			goto EXIT;
-		}
+// Array indexes (example: 0,1,-1), the negative indexes are added after the others
+static CJPathStatus compileIndexes(const char* ptr, const char* end, CompileBuilder* builder, CJPathStep* step)
+{
+	const char* cur;
+	ptrdiff_t value;
+	int pass;
 
-		result->strLen = (size_t)(ptrEnd - ptr) + 1;
-	}
+	step->type = STEP_INDEXES;
 
-	// Find end of array
-	else if (ptr[0] == '[')
+	for (pass = 0; pass < 2; ++pass)
 	{
-		for (ptrEnd = ptr, cnt1 = 0, cnt2 = 0; ptrEnd != endOfFile; ++ptrEnd)
-		{
+		if (pass == 1)
+			step->tailIndexes = (builder->indexes != NULL) ? builder->indexes + builder->indexCount : NULL;
 
-			if (ptrEnd[0] == '[')
-				++cnt1;
+		for (cur = ptr; ; ++cur) // by pass ,
+		{
+			if (!parseSignedIndex(&cur, end, &value))
+				return INVALID_JSON_PATH;
 
-			if (ptrEnd[0] == ']')
-				++cnt2;
+			if (pass == 0 && value >= 0)
+			{
+				addIndex(builder, (size_t)value);
+				++step->count;
+			}
+			else if (pass == 1 && value < 0)
+			{
+				addIndex(builder, (size_t)-value);
+				++step->tailCount;
+			}
 
-			if (cnt1 == cnt2)
+			if (cur == end)
 				break;
-		}
 
-		if (ptrEnd >= endOfFile)
-		{
-			status = INVALID_JSON;
-			goto EXIT;
+			if (cur[0] != ',')
+				return INVALID_JSON_PATH;
 		}
-
-		result->strLen = (size_t)(ptrEnd - ptr) + 1;
 	}
 
-	else if (strncmp(ptr, JSON_VALUE_TRUE, JSON_VALUE_TRUE_LEN) == 0)
-		result->strLen = JSON_VALUE_TRUE_LEN;
-
-	else if (strncmp(ptr, JSON_VALUE_NULL, JSON_VALUE_NULL_LEN) == 0)
-		result->strLen = JSON_VALUE_NULL_LEN;
+	step->fromEnd = (step->tailCount != 0);
 
-	else if (strncmp(ptr, JSON_VALUE_FALSE, JSON_VALUE_FALSE_LEN) == 0)
-		result->strLen = JSON_VALUE_FALSE_LEN;
-
-	else
+	if (builder->steps != NULL)
 	{
-		if (extractFirst)
-			status = NOT_FOUND;
-		else
-			status = INVALID_JSON;
+		step->count = sortIndexes((size_t*)step->indexes, step->count);
+		step->tailCount = sortIndexes((size_t*)step->tailIndexes, step->tailCount);
 	}
 
-EXIT:
-	if (!extractFirst)
-		memFreeFunc(buildName);
-
-	return status;
+	return SUCCESS;
 }
 
-static CJPathStatus parsePath(const char* jsonData, size_t jsonDataLen,
-	const char* path, size_t pathLen, CJPathList** resultList, MemAllocFunc memAllocFunc, MemFreeFunc memFreeFunc)
+// Array slice (example: 0:2, -2:, ::2, ::-1)
+static CJPathStatus compileSlice(const char* ptr, const char* end, CJPathStep* step)
 {
-	CJPathStatus status;
+	bool hasFrom, hasTo;
 
-	size_t pathOffset;
-	size_t i, j, count, maxCount;
-	size_t* array;
-	size_t fromValue, toValue;
+	step->type = STEP_SLICE;
+	step->stepValue = 1;
 
-	CJPathResult res;
-	CJPathResult* arrNames;
-
-	const char* ptrTmp;
-	const char* ptrTmp2;
+	hasFrom = parseSignedIndex(&ptr, end, &step->fromValue);
 
-	bool present;
+	if (ptr == end || ptr[0] != ':')
+		return INVALID_JSON_PATH;
+	++ptr; // by pass :
 
-	status = SUCCESS;
+	hasTo = parseSignedIndex(&ptr, end, &step->toValue);
 
-	// Child element by . (example: $.name)
-	if (pathLen >= 2 && path[0] == '.' && path[1] != '.' && path[1] != '*')
+	if (ptr != end && ptr[0] == ':')
 	{
-		pathOffset = getOffsetChildByDot(++path, --pathLen);
-		if (!pathOffset)
+		++ptr; // by pass :
+		if (parseSignedIndex(&ptr, end, &step->stepValue) && step->stepValue == 0)
 			return INVALID_JSON_PATH;
+	}
 
-		status = processingPath(path, pathOffset, jsonData, jsonDataLen, &res, false, memAllocFunc, memFreeFunc);
-		if (status != SUCCESS)
-			return status;
+	if (skipSpaces(ptr, end) != end)
+		return INVALID_JSON_PATH;
 
-		if ((pathLen - pathOffset) == 1)  // Only null-terminator left
-		{
-			if ((*resultList = addResultToList(resultList, &res, memAllocFunc)) == NULL)
-				return BAD_ALLOC;
-		}
+	// The missing bounds cover the whole array in the step direction
+	if (!hasFrom)
+		step->fromValue = (step->stepValue > 0) ? 0 : PTRDIFF_MAX;
+	if (!hasTo)
+		step->toValue = (step->stepValue > 0) ? PTRDIFF_MAX : PTRDIFF_MIN;
 
-		jsonData = res.strPtr;
-		jsonDataLen = res.strLen;
+	if (step->stepValue > 0 && step->fromValue >= 0 && step->toValue >= 0 && step->toValue <= step->fromValue)
+		return INVALID_JSON_PATH;
 
-		RETURN_NEXT_PARSE(pathOffset);
-	}
+	step->fromEnd = (step->fromValue < 0 || step->toValue < 0 || step->stepValue < 0);
 
-	// Child element by [] (example: $['name'])
-	else if (pathLen >= 5 && path[0] == '[' && path[1] == '\'')
-	{
-		ptrTmp = strnstr("[", path, pathLen);
-		ptrTmp2 = strnstr("]", path, pathLen);
-		pathOffset = ptrTmp2 - path + 1;
+	return SUCCESS;
+}
 
-		if (ptrTmp == NULL || ptrTmp2 == NULL)
-			return INVALID_JSON_PATH;
+// Splits the path (without $) into steps
+static CJPathStatus compileSteps(const char* path, size_t pathLen, CompileBuilder* builder)
+{
+	CJPathStatus status;
+	CJPathStep step;
 
-		status = getStrArrayValues(path, (ptrTmp2 - ptrTmp), &arrNames, &count, memAllocFunc);
-		if (status != SUCCESS)
-			goto ERR_EXIT;
-		if (!count)
+	const char* ptr;
+	const char* end;
+	const char* nameEnd;
+	const char* bracketEnd;
+
+	for (ptr = path, end = path + pathLen; ptr != end && ptr[0] != '\0'; )
+	{
+		memset(&step, 0, sizeof(step));
+		step.names = (builder->names != NULL) ? builder->names + builder->nameCount : NULL;
+		step.indexes = (builder->indexes != NULL) ? builder->indexes + builder->indexCount : NULL;
+		step.terms = (builder->terms != NULL) ? builder->terms + builder->termCount : NULL;
+
+		// Descendants by .. (example: $..name, $..*, $..['name'], $..[0]), the rest is parsed as the child step
+		if (ptr[0] == '.' && end - ptr > 1 && ptr[1] == '.')
 		{
-			status = INVALID_JSON_PATH;
-			goto ERR_EXIT;
+			step.recursive = true;
+			++ptr; // by pass .
+
+			if (end - ptr > 1 && ptr[1] == '[')
+				++ptr; // by pass .
 		}
 
-		for (i = 0; i < count; ++i)
+		// Child element by . (example: $.name, $.*)
+		if (ptr[0] == '.')
 		{
-			status = processingPath(arrNames[i].strPtr, arrNames[i].strLen,
-				jsonData, jsonDataLen, &res, false, memAllocFunc, memFreeFunc);
-			if (status != SUCCESS)
+			++ptr; // by pass .
+
+			if (ptr != end && ptr[0] == '*')
 			{
-				goto ERR_EXIT;
-				return status;
+				step.type = STEP_WILDCARD;
+				++ptr;
 			}
-
-			if ((pathLen - pathOffset) == 1) // Only '] & null-terminator left
+			else
 			{
-				if ((*resultList = addResultToList(resultList, &res, memAllocFunc)) == NULL)
-				{
-					status = BAD_ALLOC;
-					goto ERR_EXIT;
-				}
+				for (nameEnd = ptr; nameEnd != end
+					&& nameEnd[0] != '.' && nameEnd[0] != '[' && nameEnd[0] != '\0'; ++nameEnd);
+
+				if (nameEnd == ptr)
+					return INVALID_JSON_PATH;
+
+				step.type = STEP_CHILD;
+				step.count = 1;
+				addName(builder, ptr, (size_t)(nameEnd - ptr));
+
+				ptr = nameEnd;
 			}
 		}
 
-		if (count == 1)
+		// Filter (example: $[?(@.price < 10 && @.tag)])
+		else if (ptr[0] == '[' && skipSpaces(ptr + 1, end) != end && skipSpaces(ptr + 1, end)[0] == '?')
 		{
-			jsonData = res.strPtr;
-			jsonDataLen = res.strLen;
+			status = compileFilter(&ptr, end, builder, &step);
+			if (status != SUCCESS)
+				return status;
 		}
 
-		memFreeFunc(arrNames);
-
-		RETURN_NEXT_PARSE(pathOffset);
-
-	ERR_EXIT:
-		memFreeFunc(arrNames);
-		return status;
-	}
-
-	// Array range (example: $[0:2])
-	else if (pathLen >= 5 && path[0] == '[' && isRange(path + 1, pathLen - 1))
-	{
-		if (!getRange(++path, --pathLen, &fromValue, &toValue))
-			return INVALID_JSON_PATH;
-
-		if (toValue <= fromValue)
-			return INVALID_JSON_PATH;
+		// Element by [] (example: $['name'], $[0,1], $[0:2], $[*])
+		else if (ptr[0] == '[')
+		{
+			bracketEnd = findBracketEnd(ptr + 1, end);
+			if (bracketEnd == NULL)
+				return INVALID_JSON_PATH;
 
-		// Find end
-		status = INVALID_JSON_PATH;
+			ptr = skipSpaces(ptr + 1, bracketEnd);
+			if (ptr == bracketEnd)
+				return INVALID_JSON_PATH;
 
-		for (pathOffset = 3; pathOffset < pathLen; ++pathOffset)
-		{
-			if (path[pathOffset] == ']')
+			if (ptr[0] == '\'')
+				status = compileNames(ptr, bracketEnd, builder, &step);
+			else if (ptr[0] == '*' && skipSpaces(ptr + 1, bracketEnd) == bracketEnd)
 			{
+				step.type = STEP_WILDCARD;
 				status = SUCCESS;
-				break;
 			}
+			else if (strnchr(':', ptr, (size_t)(bracketEnd - ptr)) != NULL)
+				status = compileSlice(ptr, bracketEnd, &step);
+			else
+				status = compileIndexes(ptr, bracketEnd, builder, &step);
+
+			if (status != SUCCESS)
+				return status;
+
+			ptr = bracketEnd + 1;
 		}
 
-		// Check valid path
-		if (status != SUCCESS)
-			return status;
+		else
+			return INVALID_JSON_PATH;
 
-		// Next path
-		path += (pathOffset + 1);
-		pathLen -= (pathOffset + 1);
+		addStep(builder, &step);
+	}
 
-		// Extract items
-		for (i = 0; i < toValue; ++i)
-		{
-			// Find correct value
-			for (; jsonDataLen != 0;)
-			{
-				status = processingPath(NULL, 0, jsonData, jsonDataLen, &res, true, memAllocFunc, memFreeFunc);
-				if (status == SUCCESS)
-					break;
-				else
-				{
-					// Find
-					++jsonData;
-					--jsonDataLen;
-					continue;
-				}
-			}
+	if (!builder->stepCount)
+		return INVALID_JSON_PATH;
 
-			if (!jsonDataLen)
-				break;
+	return SUCCESS;
+}
 
-			jsonDataLen -= res.strLen;
-			jsonData += (res.strPtr - jsonData) + res.strLen;
+// Processing path and extract result
+// name - child name, only the direct members of the object are compared.
+CJPathStatus processingPath(const CJPathStructuralIndex* structural, const CJPathResult* name, const char* jsonData,
+	size_t jsonDataLen, CJPathResult* result)
+{
+	CJPathStatus status;
+	CJPathResult key;
+	const char* ptr;
+	const char* const endOfFile = jsonData + jsonDataLen;
 
-			if (i >= fromValue)
-			{
-				// Extract objects from item
-				if (pathLen == 1)
-				{
-					if ((*resultList = addResultToList(resultList, &res, memAllocFunc)) == NULL)
-						return BAD_ALLOC;
-				}
-				else
-				{
-					status = parsePath(res.strPtr, res.strLen, path, pathLen, resultList, memAllocFunc, memFreeFunc);
-					if (status == NOT_FOUND)
-					{
-						++jsonData;
-						--jsonDataLen;
-						continue;
-					}
-					else if (status != SUCCESS)
-						return status;
-				}
-			}
-		}
+	STATS_ADD(pathLookups, 1);
 
-		return SUCCESS;
+	if (jsonData[0] != '{')
+		return NOT_FOUND;
+
+	for (ptr = jsonData; ptr != endOfFile && (ptr == jsonData || ptr[0] == ',');)
+	{
+		status = nextMember(structural, &ptr, endOfFile, &key, result);
+		if (status != SUCCESS)
+			return status;
+
+		if (key.strLen == name->strLen && memcmp(key.strPtr, name->strPtr, key.strLen) == 0)
+			return SUCCESS;
+	}
+
+	return NOT_FOUND;
+}
+
+static CJPathStatus evaluateStep(EvalContext* ctx, size_t stepIdx, const char* jsonData, size_t jsonDataLen);
+
+// Passes the value to the next step, or to the result list after the last step
+static CJPathStatus evaluateNext(EvalContext* ctx, size_t stepIdx, const CJPathResult* value)
+{
+	if (stepIdx + 1 == ctx->compiled->stepCount)
+	{
+		++ctx->resultCount;
+		return ctx->sink->add(ctx->sink, value);
 	}
 
-	// Array (example: $[0,1,2]  $[1])
-	else if (pathLen >= 2 && path[0] == '[' && charIsIntegerNum(path[1]))
+	return evaluateStep(ctx, stepIdx + 1, value->strPtr, value->strLen);
+}
+
+// Array (example: $[0,1,2], $[0:2], $[*], $[?(@.price < 10)])
+// Items are skipped without evaluation up to the first selected index, the walk stops after the last one.
+static CJPathStatus evaluateArrayItems(EvalContext* ctx, size_t stepIdx, const char* jsonData, size_t jsonDataLen)
+{
+	CJPathStatus status;
+	CJPathResult res;
+	const char* ptr;
+	const char* const end = jsonData + jsonDataLen;
+	size_t i, next;
+
+	const CJPathStep* const step = &ctx->compiled->steps[stepIdx];
+
+	if (jsonData[0] != '[')
+		return SUCCESS;
+
+	for (ptr = jsonData, i = 0, next = 0; ptr != end && (ptr == jsonData || ptr[0] == ','); ++i)
 	{
-		status = getNumArrayValues(++path, --pathLen, &array, &maxCount, memAllocFunc);
+		if ((step->type == STEP_INDEXES && next == step->count) || (step->type == STEP_SLICE && (ptrdiff_t)i >= step->toValue))
+			return SUCCESS;
+
+		status = nextArrayItem(ctx->structural, &ptr, end, &res);
+		if (status == NOT_FOUND)
+			break;
 		if (status != SUCCESS)
 			return status;
 
-		for (pathOffset = 1; pathOffset < pathLen; ++pathOffset)
+		if (step->type == STEP_INDEXES)
 		{
-			if (path[pathOffset] == ']')
-			{
-				break;
-			}
+			if (step->indexes[next] != i)
+				continue;
+			++next;
 		}
+		else if (step->type == STEP_SLICE && !isIndexSelected(step, i))
+			continue;
+		else if (step->type == STEP_FILTER && !filterMatches(ctx->structural, step, &res))
+			continue;
 
-		if ((pathOffset + 1) > pathLen)
-			pathLen = 1;
-		else
-		{
-			path += pathOffset + 1;
-			pathLen -= (pathOffset + 1);
-		}
+		status = evaluateNext(ctx, stepIdx, &res);
+		if (status != SUCCESS)
+			return status;
+	}
 
-		// Extract
-		for (i = 0, count = 0; ; ++i)
-		{
-			// Check
-			for (j = 0, present = 0; j < maxCount; ++j)
-			{
-				if (array[j] == i)
-				{
-					present = true;
-					break;
-				}
-			}
+	return isArrayEnd(jsonData, ptr, end) ? SUCCESS : INVALID_JSON;
+}
 
-			// Find correct value
-			for (; jsonDataLen != 0;)
-			{
-				status = processingPath(NULL, 0, jsonData, jsonDataLen, &res, true, memAllocFunc, memFreeFunc);
-
-				if (status == SUCCESS)
-					break;
-				else
-				{
-					// Find
-					++jsonData;
-					--jsonDataLen;
-					continue;
-				}
-			}
+// Number of the last items kept until the array length is known, SIZE_MAX - all items
+static size_t tailCapacity(const CJPathStep* step)
+{
+	if (step->type == STEP_INDEXES)
+		return step->tailIndexes[step->tailCount - 1];
 
-			if (!jsonDataLen)
-				break;
+	if (step->stepValue > 0)
+		return (size_t)((step->fromValue < step->toValue) ? -step->fromValue : -step->toValue);
 
-			jsonDataLen -= res.strLen;
-			jsonData += (res.strPtr - jsonData) + res.strLen;
+	return (step->toValue < 0 && step->toValue != PTRDIFF_MIN) ? (size_t)-step->toValue : SIZE_MAX;
+}
 
-			// Extract objects from item
-			if (present)
-			{
-				if (pathLen == 1)
-				{
-					if ((*resultList = addResultToList(resultList, &res, memAllocFunc)) == NULL)
-						return BAD_ALLOC;
-				}
-				else
-				{
-					status = parsePath(res.strPtr, res.strLen, path, pathLen, resultList, memAllocFunc, memFreeFunc);
-					if (status == NOT_FOUND)
-					{
-						++jsonData;
-						--jsonDataLen;
-						continue;
-					}
-					else if (status != SUCCESS)
-						return status;
-				}
-				++count;
-			}
+// Number of items read, the reversed slice ends at its start bound when the end bound is not negative
+static size_t tailReadLimit(const CJPathStep* step)
+{
+	if (step->type == STEP_SLICE && step->stepValue < 0 && step->fromValue >= 0 && step->fromValue != PTRDIFF_MAX
+		&& (step->toValue >= 0 || step->toValue == PTRDIFF_MIN))
+		return (size_t)step->fromValue + 1;
 
-		}
+	return SIZE_MAX;
+}
 
-		memFreeFunc(array);
-	}
+// Selection of the item that is not among the last kept items, so it does not depend on the array length
+static bool isLeadingIndexSelected(const CJPathStep* step, size_t index)
+{
+	if (step->type == STEP_INDEXES)
+		return isIndexSelected(step, index);
+
+	return (step->stepValue > 0 && step->fromValue >= 0 && (ptrdiff_t)index >= step->fromValue
+		&& (step->toValue < 0 || (ptrdiff_t)index < step->toValue) && ((ptrdiff_t)index - step->fromValue) % step->stepValue == 0);
+}
+
+// Doubles the kept items up to the capacity, the items are moved to the start
+static CJPathStatus growTailItems(EvalContext* ctx, CJPathResult** items, size_t* allocated, size_t* head, size_t count,
+	size_t capacity, const CJPathResult* inlineItems)
+{
+	CJPathResult* grown;
+	size_t size, i;
+
+	if (ctx->allocator == NULL)
+		return LIMIT_EXCEEDED;
+
+	size = (*allocated > capacity / 2) ? capacity : *allocated * 2;
+	grown = (CJPathResult*)allocatorAlloc(ctx->allocator, size * sizeof(CJPathResult));
+	if (grown == NULL)
+		return BAD_ALLOC;
+
+	for (i = 0; i < count; ++i)
+		grown[i] = (*items)[(*head + i) % *allocated];
+
+	if (*items != inlineItems)
+		allocatorFree(ctx->allocator, *items);
+
+	*items = grown;
+	*allocated = size;
+	*head = 0;
+
+	return SUCCESS;
+}
 
-	// Child element by .* (example: $.name.*)
-	else if ((pathLen >= 2 && path[0] == '.' && path[1] == '*')
-		|| (pathLen >= 3 && path[0] == '[' && path[1] == '*' && path[2] == ']'))
+// Array items selected from the end (example: $[-1], $[-2:], $[:-1], $[::-1])
+// The array is read once, only the last items which may be selected from the end are kept in the ring buffer.
+// The leading items are selected when they leave the buffer.
+static CJPathStatus evaluateTailItems(EvalContext* ctx, size_t stepIdx, const char* jsonData, size_t jsonDataLen)
+{
+	CJPathStatus status;
+	CJPathResult inlineItems[TAIL_INLINE_ITEMS];
+	CJPathResult* items;
+	CJPathResult res;
+	const char* ptr;
+	const char* const end = jsonData + jsonDataLen;
+	size_t capacity, limit, allocated, head, count, length, i;
+	ptrdiff_t pos, first, last;
+
+	const CJPathStep* const step = &ctx->compiled->steps[stepIdx];
+
+	if (jsonData[0] != '[')
+		return SUCCESS;
+
+	capacity = tailCapacity(step);
+	limit = tailReadLimit(step);
+
+	items = inlineItems;
+	allocated = TAIL_INLINE_ITEMS;
+
+	// The buffer of the context is taken, so the nested steps do not share it
+	if (ctx->scratch != NULL && ctx->scratch->tailItems != NULL)
 	{
-		pathOffset = (path[0] == '.') ? 2 : 3;
+		items = ctx->scratch->tailItems;
+		allocated = ctx->scratch->tailAllocated;
+		ctx->scratch->tailItems = NULL;
+	}
 
-		path += (pathOffset);
-		pathLen -= (pathOffset);
+	head = 0;
+	count = 0;
+	status = SUCCESS;
 
-		if (jsonData[0] != '[')
+	for (ptr = jsonData, length = 0; status == SUCCESS && length < limit && ptr != end && (ptr == jsonData || ptr[0] == ',');
+		++length)
+	{
+		status = nextArrayItem(ctx->structural, &ptr, end, &res);
+		if (status != SUCCESS)
+			break;
+
+		if (count == capacity)
 		{
-			while (1)
-			{
-				ptrTmp = jsonData;
-				jsonData = strnstr(":", jsonData, jsonDataLen);
-				if (jsonData == NULL)
-					break;
-				jsonDataLen -= (jsonData - ptrTmp);
-
-				status = processingPath(NULL, 0, jsonData, jsonDataLen, &res, true, memAllocFunc, memFreeFunc);
-				if (status != SUCCESS)
-					return status;
-
-				if (pathLen == 1)
-				{
-					if ((*resultList = addResultToList(resultList, &res, memAllocFunc)) == NULL)
-						return BAD_ALLOC;
-					jsonData = res.strPtr + res.strLen;
-					jsonDataLen -= res.strLen;
-				}
-				else
-				{
-					status = parsePath(res.strPtr, res.strLen, path, pathLen, resultList, memAllocFunc, memFreeFunc);
-					if (status == NOT_FOUND) // End
-						break;
-					jsonData = res.strPtr + res.strLen;
-					jsonDataLen -= res.strLen;
-				}
+			if (isLeadingIndexSelected(step, length - count))
+				status = evaluateNext(ctx, stepIdx, &items[head]);
 
-			}
+			head = (head + 1) % allocated;
+			--count;
 		}
-		else
+		else if (count == allocated)
 		{
-			status = processingPath(NULL, 0, jsonData, jsonDataLen, &res, true, memAllocFunc, memFreeFunc);
+			status = growTailItems(ctx, &items, &allocated, &head, count, capacity, inlineItems);
 			if (status != SUCCESS)
-				return status;
+				break;
+		}
 
-			// Extract
-			while (1)
-			{
+		items[(head + count) % allocated] = res;
+		++count;
+	}
 
-				// Find correct value
-				for (; jsonDataLen != 0;)
-				{
-					status = processingPath(NULL, 0, jsonData, jsonDataLen, &res, true, memAllocFunc, memFreeFunc);
-
-					if (status == SUCCESS)
-						break;
-					else
-					{
-						// Find
-						++jsonData;
-						--jsonDataLen;
-						continue;
-					}
-				}
-
-				if (!jsonDataLen)
-					break;
-
-				jsonDataLen -= res.strLen;
-				jsonData += (res.strPtr - jsonData) + res.strLen;
-
-				// Extract objects from item
-				if (pathLen == 1)
-				{
-					if ((*resultList = addResultToList(resultList, &res, memAllocFunc)) == NULL)
-						return BAD_ALLOC;
-				}
-				else
-				{
-					status = parsePath(res.strPtr, res.strLen, path, pathLen, resultList, memAllocFunc, memFreeFunc);
-					if (status == NOT_FOUND)
-					{
-						++jsonData;
-						--jsonDataLen;
-						continue;
-					}
-					else if (status != SUCCESS)
-						return status;
-				}
-			}
+	// The read limit stops the walk before the end of the array
+	if (status == NOT_FOUND || (status == SUCCESS && length < limit))
+		status = isArrayEnd(jsonData, ptr, end) ? SUCCESS : INVALID_JSON;
+
+	if (step->type == STEP_SLICE && step->stepValue < 0)
+	{
+		resolveSlice(step, length, &first, &last);
+		for (pos = first; status == SUCCESS && pos > last && pos >= (ptrdiff_t)(length - count); pos += step->stepValue)
+			status = evaluateNext(ctx, stepIdx, &items[(head + (size_t)pos - (length - count)) % allocated]);
+	}
+	else
+	{
+		for (i = 0; status == SUCCESS && i < count; ++i)
+		{
+			if (isTailIndexSelected(step, length - count + i, length))
+				status = evaluateNext(ctx, stepIdx, &items[(head + i) % allocated]);
 		}
+	}
 
-		return SUCCESS;
+	if (items != inlineItems && ctx->scratch != NULL && ctx->scratch->tailItems == NULL)
+	{
+		ctx->scratch->tailItems = items;
+		ctx->scratch->tailAllocated = allocated;
 	}
+	else if (items != inlineItems)
+		allocatorFree(ctx->allocator, items);
 
-	else if (pathLen != 1)
-		return INVALID_JSON_PATH;
+	return status;
+}
+
+// Child element by .* or filtered member values (example: $.name.*, $.name[?(@.price < 10)])
+static CJPathStatus evaluateObjectWildcard(EvalContext* ctx, size_t stepIdx, const char* jsonData, size_t jsonDataLen)
+{
+	CJPathStatus status;
+	CJPathResult key, res;
+	const char* ptr;
+	const char* const endOfFile = jsonData + jsonDataLen;
+
+	if (jsonData[0] != '{')
+		return SUCCESS;
+
+	for (ptr = jsonData; ptr != endOfFile && (ptr == jsonData || ptr[0] == ',');)
+	{
+		status = nextMember(ctx->structural, &ptr, endOfFile, &key, &res);
+		if (status == NOT_FOUND)
+			break;
+		if (status != SUCCESS)
+			return status;
+
+		if (ctx->compiled->steps[stepIdx].type == STEP_FILTER && !filterMatches(ctx->structural, &ctx->compiled->steps[stepIdx], &res))
+			continue;
+
+		status = evaluateNext(ctx, stepIdx, &res);
+		if (status != SUCCESS)
+			return status;
+	}
 
 	return SUCCESS;
 }
 
-CJPathStatus CJPathProcessing(const char* jsonData, size_t jsonDataLen,
-	const char* jsonPath, size_t jsonPathLen, CJPathList** resultList, MemAllocFunc memAllocFunc, MemFreeFunc memFreeFunc)
+// Applies the step to the children of the value
+static CJPathStatus applyStep(EvalContext* ctx, size_t stepIdx, const char* jsonData, size_t jsonDataLen)
 {
 	CJPathStatus status;
-	if (jsonData == NULL || jsonPath == NULL || resultList == NULL)
-		return INVALID_ARGUMENT;
+	CJPathResult res;
+	size_t i;
 
-	if (jsonDataLen < 5)
-		return INVALID_JSON;
+	const CJPathStep* const step = &ctx->compiled->steps[stepIdx];
 
-	if (!(jsonPath[0] == '$' && (jsonPath[1] == '[' || jsonPath[1] == '.') && jsonPathLen >= 3))
-		return INVALID_JSON_PATH;
+	switch (step->type)
+	{
+	case STEP_CHILD:
+		for (i = 0; i < step->count; ++i)
+		{
+			status = processingPath(ctx->structural, &step->names[i], jsonData, jsonDataLen, &res);
+			if (status == NOT_FOUND)
+				continue;
+			if (status != SUCCESS)
+				return status;
+
+			status = evaluateNext(ctx, stepIdx, &res);
+			if (status != SUCCESS)
+				return status;
+		}
+		return SUCCESS;
+
+	case STEP_WILDCARD:
+	case STEP_FILTER:
+		if (jsonData[0] != '[')
+			return evaluateObjectWildcard(ctx, stepIdx, jsonData, jsonDataLen);
+		return evaluateArrayItems(ctx, stepIdx, jsonData, jsonDataLen);
+
+	default:
+		if (step->fromEnd)
+			return evaluateTailItems(ctx, stepIdx, jsonData, jsonDataLen);
+		return evaluateArrayItems(ctx, stepIdx, jsonData, jsonDataLen);
+	}
+}
+
+// Pushes the object or array to the work stack of the descendant walk
+static CJPathStatus pushFrame(EvalContext* ctx, const char* jsonData, size_t jsonDataLen)
+{
+	DescentFrame* frames;
+	DescentFrame* frame;
+
+	if (ctx->frameCount == ctx->frameCapacity)
+	{
+		if (ctx->allocator == NULL)
+			return LIMIT_EXCEEDED;
+
+		frames = (DescentFrame*)allocatorAlloc(ctx->allocator, ctx->frameCapacity * 2 * sizeof(DescentFrame));
+		if (frames == NULL)
+			return BAD_ALLOC;
+
+		memcpy(frames, ctx->frames, ctx->frameCount * sizeof(DescentFrame));
+		if (ctx->frames != ctx->inlineFrames)
+			allocatorFree(ctx->allocator, ctx->frames);
+
+		ctx->frames = frames;
+		ctx->frameCapacity *= 2;
+	}
+
+	frame = &ctx->frames[ctx->frameCount++];
+	frame->start = jsonData;
+	frame->ptr = jsonData;
+	frame->end = jsonData + jsonDataLen;
+
+	return SUCCESS;
+}
+
+// Memory of the index built by the descendant walk and released by it, the arena gives its chunk functions
+static void indexMemoryFuncs(const CJPathAllocator* allocator, MemAllocFunc* memAllocFunc, MemFreeFunc* memFreeFunc)
+{
+	*memAllocFunc = (allocator->arena != NULL) ? allocator->arena->memAllocFunc : allocator->memAllocFunc;
+	*memFreeFunc = (allocator->arena != NULL) ? allocator->arena->memFreeFunc : allocator->memFreeFunc;
+}
+
+static void releaseDescendantsIndex(EvalContext* ctx, CJPathStructuralIndex* index)
+{
+	MemAllocFunc memAllocFunc;
+	MemFreeFunc memFreeFunc;
 
-	status = parsePath(jsonData, jsonDataLen, jsonPath + 1, jsonPathLen, resultList, memAllocFunc, memFreeFunc);
+	ctx->structural = NULL;
 
-	// Set list to begin
-	if (*resultList != NULL)
+	if (ctx->scratch != NULL && ctx->scratch->index == NULL)
 	{
-		CJPathList* prevPtr;
-		do
+		ctx->scratch->index = index;
+		return;
+	}
+
+	indexMemoryFuncs(ctx->allocator, &memAllocFunc, &memFreeFunc);
+	CJPathFreeStructuralIndex(&index, memFreeFunc);
+}
+
+// Indexes the value of the descendant walk, so the nested values are skipped without scanning them again.
+// Returns NULL if the evaluation has the index already or no memory functions.
+static CJPathStructuralIndex* indexDescendants(EvalContext* ctx, const char* jsonData, size_t jsonDataLen)
+{
+	CJPathStructuralIndex* index;
+	MemAllocFunc memAllocFunc;
+	MemFreeFunc memFreeFunc;
+
+	if (ctx->structural != NULL || ctx->allocator == NULL)
+		return NULL;
+
+	indexMemoryFuncs(ctx->allocator, &memAllocFunc, &memFreeFunc);
+	if (memAllocFunc == NULL)
+		return NULL;
+
+	// The index of the previous call is refilled
+	index = NULL;
+	if (ctx->scratch != NULL)
+	{
+		index = ctx->scratch->index;
+		ctx->scratch->index = NULL;
+	}
+
+	if (index == NULL)
+	{
+		index = (CJPathStructuralIndex*)memAllocFunc(sizeof(CJPathStructuralIndex));
+		if (index == NULL)
+			return NULL;
+		memset(index, 0, sizeof(*index));
+	}
+
+	if (fillStructuralIndex(index, jsonData, jsonDataLen, memAllocFunc, memFreeFunc) != SUCCESS)
+	{
+		releaseDescendantsIndex(ctx, index);
+		return NULL;
+	}
+
+	ctx->structural = index;
+	return index;
+}
+
+// Descendants (example: $..name, $..*, $..[0])
+// The step is applied to the value and to all nested objects and arrays in document order. Nested values are walked
+// with the work stack, so the C stack does not depend on the document nesting. Each open level skips the nested values
+// once more, so past DESCENT_INDEX_DEPTH levels the value is indexed and the rest of the walk skips them by the index.
+static CJPathStatus evaluateDescendants(EvalContext* ctx, size_t stepIdx, const char* jsonData, size_t jsonDataLen)
+{
+	CJPathStatus status;
+	CJPathResult key, res;
+	CJPathStructuralIndex* index;
+	DescentFrame* frame;
+	const size_t base = ctx->frameCount;
+	bool indexed;
+
+	status = applyStep(ctx, stepIdx, jsonData, jsonDataLen);
+	if (status != SUCCESS || (jsonData[0] != '{' && jsonData[0] != '['))
+		return status;
+
+	status = pushFrame(ctx, jsonData, jsonDataLen);
+	index = NULL;
+	indexed = false;
+
+	while (status == SUCCESS && ctx->frameCount > base)
+	{
+		// The frames may be moved by the nested steps
+		frame = &ctx->frames[ctx->frameCount - 1];
+
+		if (frame->ptr == frame->end || (frame->ptr != frame->start && frame->ptr[0] != ','))
+			status = NOT_FOUND;
+		else if (frame->start[0] == '{')
+			status = nextMember(ctx->structural, &frame->ptr, frame->end, &key, &res);
+		else
+			status = nextArrayItem(ctx->structural, &frame->ptr, frame->end, &res);
+
+		// All children are walked
+		if (status == NOT_FOUND)
+		{
+			--ctx->frameCount;
+			status = SUCCESS;
+			continue;
+		}
+
+		if (status == SUCCESS && (res.strPtr[0] == '{' || res.strPtr[0] == '['))
 		{
-			prevPtr = (*resultList)->prev;
-			*resultList = prevPtr->prev;
-		} while (prevPtr != *resultList);
+			status = applyStep(ctx, stepIdx, res.strPtr, res.strLen);
+			if (status == SUCCESS)
+				status = pushFrame(ctx, res.strPtr, res.strLen);
+
+			if (status == SUCCESS && !indexed && ctx->frameCount - base == DESCENT_INDEX_DEPTH)
+			{
+				index = indexDescendants(ctx, jsonData, jsonDataLen);
+				indexed = true;
+			}
+		}
 	}
 
-	if (status != SUCCESS)
-		CJPathFreeList(resultList, memFreeFunc);
+	ctx->frameCount = base;
+
+	if (index != NULL)
+		releaseDescendantsIndex(ctx, index);
 
 	return status;
 }
 
-void CJPathFreeList(CJPathList** list, MemFreeFunc memFreeFunc)
+static CJPathStatus evaluateStep(EvalContext* ctx, size_t stepIdx, const char* jsonData, size_t jsonDataLen)
 {
-	while (*list != NULL)
+	CJPathStatus status;
+
+	// Nested steps and the open levels of the descendant walk
+	STATS_MAX(maxDepth, stepIdx + 1 + ctx->frameCount);
+
+	if (ctx->compiled->steps[stepIdx].recursive)
+		status = evaluateDescendants(ctx, stepIdx, jsonData, jsonDataLen);
+	else
+		status = applyStep(ctx, stepIdx, jsonData, jsonDataLen);
+
+	return status;
+}
+
+static CJPathStatus compile(const char* jsonPath, size_t jsonPathLen, CJPathCompiled** compiled, const CJPathAllocator* allocator)
+{
+	CJPathStatus status;
+	CompileBuilder builder;
+	CJPathCompiled* ptr;
+	size_t stepsOffset, namesOffset, termsOffset, indexesOffset, charsOffset, size;
+
+	*compiled = NULL;
+
+	if (!(jsonPathLen >= 3 && jsonPath[0] == '$' && (jsonPath[1] == '[' || jsonPath[1] == '.')))
+		return INVALID_JSON_PATH;
+
+	// Calc sizes
+	memset(&builder, 0, sizeof(builder));
+	status = compileSteps(jsonPath + 1, jsonPathLen - 1, &builder);
+	if (status != SUCCESS)
+		return status;
+
+	// Steps, names, filter terms, indexes and names text are stored in one block
+	stepsOffset = sizeof(CJPathCompiled);
+	namesOffset = stepsOffset + builder.stepCount * sizeof(CJPathStep);
+	termsOffset = namesOffset + builder.nameCount * sizeof(CJPathResult);
+	indexesOffset = termsOffset + builder.termCount * sizeof(CJPathFilterTerm);
+	charsOffset = indexesOffset + builder.indexCount * sizeof(size_t);
+	size = charsOffset + builder.charCount;
+
+	ptr = (CJPathCompiled*)allocatorAlloc(allocator, size);
+	if (ptr == NULL)
+		return BAD_ALLOC;
+
+	memset(&builder, 0, sizeof(builder));
+	builder.steps = (CJPathStep*)((char*)ptr + stepsOffset);
+	builder.names = (CJPathResult*)((char*)ptr + namesOffset);
+	builder.terms = (CJPathFilterTerm*)((char*)ptr + termsOffset);
+	builder.indexes = (size_t*)((char*)ptr + indexesOffset);
+	builder.chars = (char*)ptr + charsOffset;
+
+	// Fill
+	compileSteps(jsonPath + 1, jsonPathLen - 1, &builder);
+
+	ptr->stepCount = builder.stepCount;
+	ptr->steps = builder.steps;
+
+	*compiled = ptr;
+
+	return SUCCESS;
+}
+
+CJPathStatus CJPathCompile(const char* jsonPath, size_t jsonPathLen, CJPathCompiled** compiled, MemAllocFunc memAllocFunc)
+{
+	CJPathAllocator allocator;
+
+	if (jsonPath == NULL || compiled == NULL || memAllocFunc == NULL)
+		return INVALID_ARGUMENT;
+
+	allocator.memAllocFunc = memAllocFunc;
+	allocator.memFreeFunc = NULL;
+	allocator.arena = NULL;
+
+	return compile(jsonPath, jsonPathLen, compiled, &allocator);
+}
+
+static void initEvalContext(EvalContext* ctx, const CJPathCompiled* compiled, const CJPathStructuralIndex* structural,
+	ResultSink* sink, const CJPathAllocator* allocator, EvalScratch* scratch)
+{
+	ctx->compiled = compiled;
+	ctx->structural = structural;
+	ctx->sink = sink;
+	ctx->resultCount = 0;
+	ctx->allocator = allocator;
+	ctx->frames = ctx->inlineFrames;
+	ctx->frameCount = 0;
+	ctx->frameCapacity = DESCENT_INLINE_FRAMES;
+	ctx->scratch = scratch;
+
+	if (scratch != NULL && scratch->frames != NULL)
 	{
-		CJPathList* tmp = *list;
-		*list = (*list)->next;
-		memFreeFunc(tmp);
+		ctx->frames = scratch->frames;
+		ctx->frameCapacity = scratch->frameCapacity;
+	}
+}
+
+// The grown work stack is kept by the context or released
+static void releaseEvalContext(EvalContext* ctx)
+{
+	if (ctx->frames != ctx->inlineFrames && ctx->scratch != NULL)
+	{
+		ctx->scratch->frames = ctx->frames;
+		ctx->scratch->frameCapacity = ctx->frameCapacity;
 	}
+	else if (ctx->frames != ctx->inlineFrames)
+		allocatorFree(ctx->allocator, ctx->frames);
+}
 
-	*list = NULL;
+static CJPathStatus evaluateText(const char* jsonData, size_t jsonDataLen, const CJPathCompiled* compiled,
+	const CJPathStructuralIndex* structural, ResultSink* sink, const CJPathAllocator* allocator, EvalScratch* scratch)
+{
+	CJPathStatus status;
+	EvalContext ctx;
+	const char* ptr;
+
+	if (jsonDataLen < 5)
+		return INVALID_JSON;
+
+	initEvalContext(&ctx, compiled, structural, sink, allocator, scratch);
+
+	// Root element
+	ptr = skipSpaces(jsonData, jsonData + jsonDataLen);
+	jsonDataLen -= (size_t)(ptr - jsonData);
+
+	if (jsonDataLen != 0)
+		status = evaluateStep(&ctx, 0, ptr, jsonDataLen);
+	else
+		status = SUCCESS;
+
+	releaseEvalContext(&ctx);
+
+	if (status == SUCCESS && !ctx.resultCount)
+		status = NOT_FOUND;
+
+	return status;
+}
+
+// The items of the array part are selected by their index in the whole array
+CJPathStatus evaluateArrayRange(const CJPathCompiled* compiled, size_t stepIdx, const char* jsonData, const char* end,
+	size_t firstIndex, CJPathArray* resultArray, const CJPathAllocator* allocator)
+{
+	CJPathStatus status;
+	EvalContext ctx;
+	ArraySink array;
+	CJPathResult res;
+	const char* ptr;
+	size_t i;
+
+	const CJPathStep* const step = &compiled->steps[stepIdx];
+
+	array.sink.add = &addResultToArray;
+	array.array = resultArray;
+	array.allocator = allocator;
+
+	initEvalContext(&ctx, compiled, NULL, &array.sink, allocator, NULL);
+
+	status = SUCCESS;
+	for (ptr = jsonData, i = firstIndex; status == SUCCESS && ptr != end && (ptr == jsonData || ptr[0] == ','); ++i)
+	{
+		if ((step->type == STEP_INDEXES && i > step->indexes[step->count - 1]) || (step->type == STEP_SLICE && (ptrdiff_t)i >= step->toValue))
+			break;
+
+		// The part ends after the comma of its last item
+		status = nextArrayItem(NULL, &ptr, end, &res);
+		if (status == NOT_FOUND)
+		{
+			status = SUCCESS;
+			break;
+		}
+		if (status != SUCCESS)
+			break;
+
+		if ((step->type == STEP_INDEXES || step->type == STEP_SLICE) && !isIndexSelected(step, i))
+			continue;
+		if (step->type == STEP_FILTER && !filterMatches(NULL, step, &res))
+			continue;
+
+		status = evaluateNext(&ctx, stepIdx, &res);
+	}
+
+	releaseEvalContext(&ctx);
+
+	return status;
+}
+
+static CJPathStatus evaluate(const char* jsonData, size_t jsonDataLen, const CJPathCompiled* compiled,
+	const CJPathStructuralIndex* structural, const CJPathDocIndex* docIndex, ResultSink* sink, const CJPathAllocator* allocator)
+{
+	CJPathStatus status;
+
+	STATS_EVALUATION(status = (docIndex != NULL) ? evaluateDocIndex(docIndex, compiled, sink)
+		: evaluateText(jsonData, jsonDataLen, compiled, structural, sink, allocator, NULL));
+
+	// The sink has all required results
+	if (status == EVALUATION_STOPPED)
+		status = SUCCESS;
+
+	return status;
+}
+
+static CJPathStatus evaluateToList(const char* jsonData, size_t jsonDataLen, const CJPathCompiled* compiled,
+	const CJPathStructuralIndex* structural, const CJPathDocIndex* docIndex, CJPathList** resultList, const CJPathAllocator* allocator)
+{
+	CJPathStatus status;
+	ListSink list;
+
+	list.sink.add = &addResultToList;
+	list.head = *resultList;
+	list.tail = *resultList;
+	list.allocator = allocator;
+
+	// New items are added to the end of the existing list
+	if (list.tail != NULL)
+	{
+		while (list.tail->next != NULL)
+			list.tail = list.tail->next;
+	}
+
+	status = evaluate(jsonData, jsonDataLen, compiled, structural, docIndex, &list.sink, allocator);
+
+	*resultList = list.head;
+
+	if (status != SUCCESS)
+	{
+		if (allocator->arena == NULL)
+			CJPathFreeList(resultList, allocator->memFreeFunc);
+		else
+			*resultList = NULL;
+	}
+
+	return status;
+}
+
+CJPathStatus CJPathEvaluate(const char* jsonData, size_t jsonDataLen, const CJPathCompiled* compiled,
+	CJPathList** resultList, MemAllocFunc memAllocFunc, MemFreeFunc memFreeFunc)
+{
+	CJPathAllocator allocator;
+
+	if (jsonData == NULL || compiled == NULL || resultList == NULL || memAllocFunc == NULL || memFreeFunc == NULL)
+		return INVALID_ARGUMENT;
+
+	allocator.memAllocFunc = memAllocFunc;
+	allocator.memFreeFunc = memFreeFunc;
+	allocator.arena = NULL;
+
+	return evaluateToList(jsonData, jsonDataLen, compiled, NULL, NULL, resultList, &allocator);
+}
+
+CJPathStatus CJPathEvaluateIndexed(const CJPathStructuralIndex* structural, const CJPathCompiled* compiled,
+	CJPathList** resultList, MemAllocFunc memAllocFunc, MemFreeFunc memFreeFunc)
+{
+	CJPathAllocator allocator;
+
+	if (structural == NULL || compiled == NULL || resultList == NULL || memAllocFunc == NULL || memFreeFunc == NULL)
+		return INVALID_ARGUMENT;
+
+	allocator.memAllocFunc = memAllocFunc;
+	allocator.memFreeFunc = memFreeFunc;
+	allocator.arena = NULL;
+
+	return evaluateToList(structural->jsonData, structural->jsonDataLen, compiled, structural, NULL, resultList, &allocator);
+}
+
+CJPathStatus CJPathEvaluateArena(const char* jsonData, size_t jsonDataLen, const CJPathCompiled* compiled,
+	CJPathList** resultList, CJPathArena* arena)
+{
+	CJPathAllocator allocator;
+
+	if (jsonData == NULL || compiled == NULL || resultList == NULL || arena == NULL)
+		return INVALID_ARGUMENT;
+
+	allocator.memAllocFunc = NULL;
+	allocator.memFreeFunc = NULL;
+	allocator.arena = arena;
+
+	return evaluateToList(jsonData, jsonDataLen, compiled, NULL, NULL, resultList, &allocator);
+}
+
+CJPathStatus CJPathEvaluateArray(const char* jsonData, size_t jsonDataLen, const CJPathCompiled* compiled,
+	CJPathArray* resultArray, MemAllocFunc memAllocFunc, MemFreeFunc memFreeFunc)
+{
+	CJPathStatus status;
+	CJPathAllocator allocator;
+	ArraySink array;
+	size_t count;
+
+	if (jsonData == NULL || compiled == NULL || resultArray == NULL || memAllocFunc == NULL || memFreeFunc == NULL)
+		return INVALID_ARGUMENT;
+
+	allocator.memAllocFunc = memAllocFunc;
+	allocator.memFreeFunc = memFreeFunc;
+	allocator.arena = NULL;
+
+	array.sink.add = &addResultToArray;
+	array.array = resultArray;
+	array.allocator = &allocator;
+
+	count = resultArray->count;
+
+	status = evaluate(jsonData, jsonDataLen, compiled, NULL, NULL, &array.sink, &allocator);
+
+	// Drop the items of the failed evaluation, the memory is kept for reuse
+	if (status != SUCCESS)
+		resultArray->count = count;
+
+	return status;
+}
+
+CJPathStatus CJPathEvaluateBuffer(const char* jsonData, size_t jsonDataLen, const CJPathCompiled* compiled,
+	CJPathResult* results, size_t capacity, size_t* count)
+{
+	CJPathStatus status;
+	BufferSink buffer;
+
+	if (jsonData == NULL || compiled == NULL || (results == NULL && capacity != 0) || count == NULL)
+		return INVALID_ARGUMENT;
+
+	buffer.sink.add = &addResultToBuffer;
+	buffer.results = results;
+	buffer.capacity = capacity;
+	buffer.count = 0;
+
+	status = evaluate(jsonData, jsonDataLen, compiled, NULL, NULL, &buffer.sink, NULL);
+
+	*count = (status == SUCCESS) ? buffer.count : 0;
+
+	if (status == SUCCESS && buffer.count > capacity)
+		status = BUFFER_TOO_SMALL;
+
+	return status;
+}
+
+CJPathStatus CJPathEvaluateTyped(const char* jsonData, size_t jsonDataLen, const CJPathCompiled* compiled,
+	CJPathTypedResult* results, size_t capacity, size_t* count)
+{
+	CJPathStatus status;
+	TypedBufferSink buffer;
+
+	if (jsonData == NULL || compiled == NULL || (results == NULL && capacity != 0) || count == NULL)
+		return INVALID_ARGUMENT;
+
+	buffer.sink.add = &addTypedResultToBuffer;
+	buffer.results = results;
+	buffer.capacity = capacity;
+	buffer.count = 0;
+	buffer.countChildren = true;
+
+	status = evaluate(jsonData, jsonDataLen, compiled, NULL, NULL, &buffer.sink, NULL);
+
+	*count = (status == SUCCESS) ? buffer.count : 0;
+
+	if (status == SUCCESS && buffer.count > capacity)
+		status = BUFFER_TOO_SMALL;
+
+	return status;
+}
+
+CJPathStatus CJPathEvaluateDocIndexTyped(const CJPathDocIndex* docIndex, const CJPathCompiled* compiled,
+	CJPathTypedResult* results, size_t capacity, size_t* count)
+{
+	CJPathStatus status;
+	TypedBufferSink buffer;
+
+	if (docIndex == NULL || compiled == NULL || (results == NULL && capacity != 0) || count == NULL)
+		return INVALID_ARGUMENT;
+
+	buffer.sink.add = &addTypedResultToBuffer;
+	buffer.results = results;
+	buffer.capacity = capacity;
+	buffer.count = 0;
+	buffer.countChildren = false;
+
+	status = evaluate(NULL, 0, compiled, NULL, docIndex, &buffer.sink, NULL);
+
+	*count = (status == SUCCESS) ? buffer.count : 0;
+
+	if (status == SUCCESS && buffer.count > capacity)
+		status = BUFFER_TOO_SMALL;
+
+	return status;
+}
+
+CJPathStatus CJPathEvaluateDocIndex(const CJPathDocIndex* docIndex, const CJPathCompiled* compiled,
+	CJPathList** resultList, MemAllocFunc memAllocFunc, MemFreeFunc memFreeFunc)
+{
+	CJPathAllocator allocator;
+
+	if (docIndex == NULL || compiled == NULL || resultList == NULL || memAllocFunc == NULL || memFreeFunc == NULL)
+		return INVALID_ARGUMENT;
+
+	allocator.memAllocFunc = memAllocFunc;
+	allocator.memFreeFunc = memFreeFunc;
+	allocator.arena = NULL;
+
+	return evaluateToList(NULL, 0, compiled, NULL, docIndex, resultList, &allocator);
+}
+
+CJPathStatus CJPathEvaluateCallback(const char* jsonData, size_t jsonDataLen, const CJPathCompiled* compiled,
+	CJPathResultCallback callback, void* userData)
+{
+	CallbackSink sink;
+
+	if (jsonData == NULL || compiled == NULL || callback == NULL)
+		return INVALID_ARGUMENT;
+
+	sink.sink.add = &addResultToCallback;
+	sink.callback = callback;
+	sink.userData = userData;
+
+	return evaluate(jsonData, jsonDataLen, compiled, NULL, NULL, &sink.sink, &heapAllocator);
+}
+
+CJPathStatus CJPathForEach(const char* jsonData, size_t jsonDataLen, const char* jsonPath, size_t jsonPathLen,
+	CJPathResultCallback callback, void* userData)
+{
+	CJPathStatus status;
+	CJPathAllocator allocator;
+	CJPathArena arena;
+	CJPathCompiled* compiled;
+	char buffer[CJPATH_FOREACH_PATH_SIZE];
+
+	if (jsonData == NULL || jsonPath == NULL || callback == NULL)
+		return INVALID_ARGUMENT;
+
+	// The arena without chunks uses only the buffer
+	CJPathArenaInit(&arena, buffer, sizeof(buffer), 0, NULL, NULL);
+
+	allocator.memAllocFunc = NULL;
+	allocator.memFreeFunc = NULL;
+	allocator.arena = &arena;
+
+	// The only allocation of the compilation fails if the path does not fit into the buffer
+	status = compile(jsonPath, jsonPathLen, &compiled, &allocator);
+	if (status == BAD_ALLOC)
+		return BUFFER_TOO_SMALL;
+	if (status != SUCCESS)
+		return status;
+
+	return CJPathEvaluateCallback(jsonData, jsonDataLen, compiled, callback, userData);
+}
+
+CJPathStatus CJPathFirst(const char* jsonData, size_t jsonDataLen, const CJPathCompiled* compiled, CJPathResult* result)
+{
+	FirstSink first;
+
+	if (jsonData == NULL || compiled == NULL || result == NULL)
+		return INVALID_ARGUMENT;
+
+	first.sink.add = &addFirstResult;
+	first.result = result;
+
+	return evaluate(jsonData, jsonDataLen, compiled, NULL, NULL, &first.sink, &heapAllocator);
+}
+
+CJPathStatus CJPathExists(const char* jsonData, size_t jsonDataLen, const CJPathCompiled* compiled)
+{
+	ResultSink sink;
+
+	if (jsonData == NULL || compiled == NULL)
+		return INVALID_ARGUMENT;
+
+	sink.add = &stopAtResult;
+
+	return evaluate(jsonData, jsonDataLen, compiled, NULL, NULL, &sink, &heapAllocator);
+}
+
+CJPathStatus CJPathCount(const char* jsonData, size_t jsonDataLen, const CJPathCompiled* compiled, size_t* count)
+{
+	CJPathStatus status;
+	CountSink counter;
+
+	if (jsonData == NULL || compiled == NULL || count == NULL)
+		return INVALID_ARGUMENT;
+
+	counter.sink.add = &countResult;
+	counter.count = 0;
+
+	status = evaluate(jsonData, jsonDataLen, compiled, NULL, NULL, &counter.sink, &heapAllocator);
+
+	*count = (status == SUCCESS) ? counter.count : 0;
+
+	return status;
+}
+
+void CJPathFreeCompiled(CJPathCompiled** compiled, MemFreeFunc memFreeFunc)
+{
+	if (compiled == NULL || *compiled == NULL)
+		return;
+
+	memFreeFunc(*compiled);
+	*compiled = NULL;
+}
+
+CJPathStatus CJPathProcessing(const char* jsonData, size_t jsonDataLen,
+	const char* jsonPath, size_t jsonPathLen, CJPathList** resultList, MemAllocFunc memAllocFunc, MemFreeFunc memFreeFunc)
+{
+	CJPathStatus status;
+	CJPathCompiled* compiled;
+
+	if (jsonData == NULL || jsonPath == NULL || resultList == NULL)
+		return INVALID_ARGUMENT;
+
+	if (jsonDataLen < 5)
+		return INVALID_JSON;
+
+	status = CJPathCompile(jsonPath, jsonPathLen, &compiled, memAllocFunc);
+	if (status != SUCCESS)
+		return status;
+
+	status = CJPathEvaluate(jsonData, jsonDataLen, compiled, resultList, memAllocFunc, memFreeFunc);
+
+	CJPathFreeCompiled(&compiled, memFreeFunc);
+
+	return status;
+}
+
+CJPathStatus CJPathProcessingArena(const char* jsonData, size_t jsonDataLen,
+	const char* jsonPath, size_t jsonPathLen, CJPathList** resultList, CJPathArena* arena)
+{
+	CJPathStatus status;
+	CJPathAllocator allocator;
+	CJPathCompiled* compiled;
+
+	if (jsonData == NULL || jsonPath == NULL || resultList == NULL || arena == NULL)
+		return INVALID_ARGUMENT;
+
+	if (jsonDataLen < 5)
+		return INVALID_JSON;
+
+	allocator.memAllocFunc = NULL;
+	allocator.memFreeFunc = NULL;
+	allocator.arena = arena;
+
+	status = compile(jsonPath, jsonPathLen, &compiled, &allocator);
+	if (status != SUCCESS)
+		return status;
+
+	return evaluateToList(jsonData, jsonDataLen, compiled, NULL, NULL, resultList, &allocator);
+}
+
+CJPathStatus CJPathProcessingArray(const char* jsonData, size_t jsonDataLen,
+	const char* jsonPath, size_t jsonPathLen, CJPathArray* resultArray, MemAllocFunc memAllocFunc, MemFreeFunc memFreeFunc)
+{
+	CJPathStatus status;
+	CJPathCompiled* compiled;
+
+	if (jsonData == NULL || jsonPath == NULL || resultArray == NULL)
+		return INVALID_ARGUMENT;
+
+	if (jsonDataLen < 5)
+		return INVALID_JSON;
+
+	status = CJPathCompile(jsonPath, jsonPathLen, &compiled, memAllocFunc);
+	if (status != SUCCESS)
+		return status;
+
+	status = CJPathEvaluateArray(jsonData, jsonDataLen, compiled, resultArray, memAllocFunc, memFreeFunc);
+
+	CJPathFreeCompiled(&compiled, memFreeFunc);
+
+	return status;
+}
+
+void CJPathFreeArray(CJPathArray* resultArray, MemFreeFunc memFreeFunc)
+{
+	if (resultArray->items != NULL)
+		memFreeFunc(resultArray->items);
+
+	resultArray->items = NULL;
+	resultArray->count = 0;
+	resultArray->capacity = 0;
+}
+
+void CJPathFreeList(CJPathList** list, MemFreeFunc memFreeFunc)
+{
+	while (*list != NULL)
+	{
+		CJPathList* tmp = *list;
+		*list = (*list)->next;
+		memFreeFunc(tmp);
+	}
+
+	*list = NULL;
+}
+
+CJPathStatus CJPathContextCreate(CJPathContext** context, MemAllocFunc memAllocFunc, MemFreeFunc memFreeFunc)
+{
+	CJPathContext* ptr;
+	CJPathStatus status;
+
+	if (context == NULL || memAllocFunc == NULL || memFreeFunc == NULL)
+		return INVALID_ARGUMENT;
+
+	*context = NULL;
+
+	ptr = (CJPathContext*)memAllocFunc(sizeof(CJPathContext));
+	if (ptr == NULL)
+		return BAD_ALLOC;
+
+	memset(ptr, 0, sizeof(CJPathContext));
+	ptr->allocator.memAllocFunc = memAllocFunc;
+	ptr->allocator.memFreeFunc = memFreeFunc;
+	ptr->allocator.arena = NULL;
+
+	status = CJPathArenaInit(&ptr->pathArena, NULL, 0, 0, memAllocFunc, memFreeFunc);
+	if (status != SUCCESS)
+	{
+		memFreeFunc(ptr);
+		return status;
+	}
+
+	*context = ptr;
+
+	return SUCCESS;
+}
+
+CJPathStatus CJPathContextEvaluate(CJPathContext* context, const char* jsonData, size_t jsonDataLen, const CJPathCompiled* compiled,
+	const CJPathArray** resultArray)
+{
+	CJPathStatus status;
+	ArraySink array;
+
+	if (context == NULL || jsonData == NULL || compiled == NULL || resultArray == NULL)
+		return INVALID_ARGUMENT;
+
+	// The items of the previous results are reused
+	context->results.count = 0;
+	*resultArray = &context->results;
+
+	array.sink.add = &addResultToArray;
+	array.array = &context->results;
+	array.allocator = &context->allocator;
+
+	STATS_EVALUATION(status = evaluateText(jsonData, jsonDataLen, compiled, NULL, &array.sink, &context->allocator, &context->scratch));
+	if (status != SUCCESS)
+		context->results.count = 0;
+
+	return status;
+}
+
+CJPathStatus CJPathContextProcessing(CJPathContext* context, const char* jsonData, size_t jsonDataLen,
+	const char* jsonPath, size_t jsonPathLen, const CJPathArray** resultArray)
+{
+	CJPathStatus status;
+	CJPathAllocator allocator;
+	CJPathCompiled* compiled;
+
+	if (context == NULL || jsonData == NULL || jsonPath == NULL || resultArray == NULL)
+		return INVALID_ARGUMENT;
+
+	// The path of the previous call is released, its chunks are reused
+	CJPathArenaReset(&context->pathArena);
+
+	allocator.memAllocFunc = NULL;
+	allocator.memFreeFunc = NULL;
+	allocator.arena = &context->pathArena;
+
+	status = compile(jsonPath, jsonPathLen, &compiled, &allocator);
+	if (status != SUCCESS)
+		return status;
+
+	return CJPathContextEvaluate(context, jsonData, jsonDataLen, compiled, resultArray);
+}
+
+void CJPathContextFree(CJPathContext** context)
+{
+	CJPathContext* ptr;
+
+	if (context == NULL || *context == NULL)
+		return;
+
+	ptr = *context;
+
+	if (ptr->scratch.frames != NULL)
+		allocatorFree(&ptr->allocator, ptr->scratch.frames);
+	if (ptr->scratch.tailItems != NULL)
+		allocatorFree(&ptr->allocator, ptr->scratch.tailItems);
+	CJPathFreeStructuralIndex(&ptr->scratch.index, ptr->allocator.memFreeFunc);
+
+	CJPathFreeArray(&ptr->results, ptr->allocator.memFreeFunc);
+	CJPathArenaDestroy(&ptr->pathArena);
+
+	ptr->allocator.memFreeFunc(ptr);
+	*context = NULL;
 }
@@ -17,6 +17,7 @@
 
 #include <stdio.h>
 #include <stdbool.h>
+#include <stdint.h>
 
 /**
 	@brief Specifies that the function is a CJPath interface.
@@ -66,7 +67,35 @@ typedef enum _CJPathStatus
 	/**
 	@brief Memory allocation error.
 	*/
-	BAD_ALLOC
+	BAD_ALLOC,
+
+	/**
+	@brief The result buffer is too small, the required number of items is returned. Also returned by CJPathForEach
+	for the JSON path which does not fit into CJPATH_FOREACH_PATH_SIZE bytes when compiled.
+	*/
+	BUFFER_TOO_SMALL,
+
+	/**
+	@brief The file cannot be opened or mapped.
+	*/
+	IO_ERROR,
+
+	/**
+	@brief The value has another type or is out of range of the requested type.
+	*/
+	INVALID_TYPE,
+
+	/**
+	@brief Returned by the result callback to stop the evaluation without an error.
+	*/
+	STOPPED,
+
+	/**
+	@brief The evaluation into the caller's buffer needs more work memory than it keeps on the stack: descendants (..)
+	nested deeper than CJPATH_BUFFER_MAX_DEPTH levels or more than CJPATH_BUFFER_MAX_TAIL last items kept for
+	the selection from the end. Such paths are evaluated by CJPathEvaluateArray.
+	*/
+	LIMIT_EXCEEDED
 } CJPathStatus;
 
 /**
@@ -103,6 +132,264 @@ struct _CJPathList
 */
 typedef struct _CJPathList CJPathList;
 
+/**
+	@brief Contiguous array containing the result of extracting data using JSON path.
+	@details Must be zero-initialized before the first use. Results are appended after count, so the memory
+	can be reused for the next document by setting count to 0.
+*/
+typedef struct
+{
+	/**
+		@brief Extracted data.
+	*/
+	CJPathResult* items;
+
+	/**
+		@brief Number of items.
+	*/
+	size_t count;
+
+	/**
+		@brief Number of allocated items.
+	*/
+	size_t capacity;
+
+} CJPathArray;
+
+/**
+	@brief Result of one record (line) of the NDJSON batch.
+*/
+typedef struct
+{
+	/**
+		@brief Record within input, without the line feed.
+	*/
+	CJPathResult record;
+
+	/**
+		@brief Evaluation status of the record.
+	*/
+	CJPathStatus status;
+
+	/**
+		@brief Index of the first extracted item in the batch results.
+	*/
+	size_t firstResult;
+
+	/**
+		@brief Number of extracted items.
+	*/
+	size_t resultCount;
+
+} CJPathRecordResult;
+
+/**
+	@brief Results of the NDJSON batch in input order.
+	@details Must be zero-initialized before the first use, the memory is reused by the next batch.
+*/
+typedef struct
+{
+	/**
+		@brief Records.
+	*/
+	CJPathRecordResult* records;
+
+	/**
+		@brief Number of records.
+	*/
+	size_t recordCount;
+
+	/**
+		@brief Number of allocated records.
+	*/
+	size_t recordCapacity;
+
+	/**
+		@brief Extracted data of all records.
+	*/
+	CJPathArray results;
+
+} CJPathBatch;
+
+/**
+	@brief Arena (bump allocator) for the internal allocations and results.
+	@details The memory is taken from the buffer provided by the caller and then from chunks allocated by memAllocFunc.
+	All memory is released at once by CJPathArenaReset (chunks are kept for reuse) or CJPathArenaDestroy.
+	The fields are internal, use CJPathArenaInit.
+*/
+typedef struct
+{
+	char* buffer;
+	size_t size;
+	size_t used;
+
+	void* firstChunk;
+	void* currentChunk;
+
+	char* initialBuffer;
+	size_t initialSize;
+	size_t chunkSize;
+
+	MemAllocFunc memAllocFunc;
+	MemFreeFunc memFreeFunc;
+} CJPathArena;
+
+/**
+	@brief JSON path compiled into a sequence of steps.
+	@details Created by CJPathCompile, immutable and can be evaluated against any number of JSON documents.
+*/
+typedef struct _CJPathCompiled CJPathCompiled;
+
+/**
+	@brief Structural index of the JSON document.
+	@details Contains positions of brackets, colons, commas and quotes outside strings, built by CJPathBuildStructuralIndex.
+*/
+typedef struct _CJPathStructuralIndex CJPathStructuralIndex;
+
+/**
+	@brief Index of the JSON document values.
+	@details Contains offsets, lengths and types of all values and links to the children of objects and arrays,
+	built once by CJPathBuildDocIndex for repeated queries.
+*/
+typedef struct _CJPathDocIndex CJPathDocIndex;
+
+/**
+	@brief Set of compiled JSON paths merged into a prefix tree.
+	@details Created by CJPathMultiCreate, all paths are evaluated in one traversal of the JSON document.
+*/
+typedef struct _CJPathMulti CJPathMulti;
+
+/**
+	@brief JSON file mapped to memory.
+	@details Created by CJPathMapFile or CJPathProcessFile, the results refer to the mapping and are valid until CJPathUnmapFile.
+*/
+typedef struct _CJPathMappedFile CJPathMappedFile;
+
+/**
+	@brief Streaming evaluator of the compiled JSON path.
+	@details Created by CJPathStreamCreate, the JSON document is passed in chunks by CJPathStreamFeed.
+*/
+typedef struct _CJPathStream CJPathStream;
+
+/**
+	@brief Evaluation context keeping the work stack, the buffers and the results between the calls.
+	@details Created by CJPathContextCreate. The context is used by one thread at a time, each worker thread keeps its
+	own context. The contexts do not share memory, so the contexts of different threads are independent. The only
+	state outside the context is the statistics pointer of the thread when the library is built with CJPATH_STATS
+	(see CJPathStatsAttach).
+*/
+typedef struct _CJPathContext CJPathContext;
+
+/**
+	@brief Function receiving the extracted data.
+	@details The result is valid only during the call. Any status other than SUCCESS stops the evaluation and is returned to the caller.
+	CJPathForEach and CJPathEvaluateCallback return SUCCESS if the callback returns STOPPED.
+*/
+typedef CJPathStatus(*CJPathResultCallback)(const CJPathResult* result, void* userData);
+
+/**
+	@brief Type of the extracted value.
+*/
+typedef enum _CJPathValueType
+{
+	TYPE_INVALID,
+	TYPE_NULL,
+	TYPE_BOOL,
+	TYPE_NUMBER,
+	TYPE_STRING,
+	TYPE_ARRAY,
+	TYPE_OBJECT
+} CJPathValueType;
+
+/**
+	@brief Statistics of the evaluations, collected only if the library is built with CJPATH_STATS.
+	@details Must be zero-initialized. The counters are added, so one structure can collect several evaluations.
+*/
+typedef struct
+{
+	/**
+		@brief Number of evaluations.
+	*/
+	uint64_t evaluations;
+
+	/**
+		@brief Bytes of the members and items read, the values read several times are counted each time.
+	*/
+	uint64_t bytesScanned;
+
+	/**
+		@brief Number of child lookups by name (processingPath).
+	*/
+	uint64_t pathLookups;
+
+	/**
+		@brief Number of single character searches (strnchr, a memchr over the rest of the text).
+	*/
+	uint64_t charSearches;
+
+	/**
+		@brief Number of allocations made by the evaluation and their total size.
+	*/
+	uint64_t allocations;
+	uint64_t allocatedBytes;
+
+	/**
+		@brief Maximum depth of the evaluation: the step nesting and the levels of the descendant walk.
+	*/
+	uint64_t maxDepth;
+
+	/**
+		@brief Total time of the evaluations in nanoseconds, each evaluation is timed as a whole.
+	*/
+	uint64_t evaluationTimeNs;
+
+} CJPathStats;
+
+/**
+	@brief Size of the stack memory for the JSON path compiled by CJPathForEach.
+	@details A step of the path takes about 100 bytes, a filter term about 60 bytes, plus the text of the names.
+*/
+#define CJPATH_FOREACH_PATH_SIZE 4096
+
+/**
+	@brief Levels of the descendant (..) walk kept on the stack by CJPathEvaluateBuffer and CJPathEvaluateTyped.
+*/
+#define CJPATH_BUFFER_MAX_DEPTH 32
+
+/**
+	@brief Last items kept on the stack by CJPathEvaluateBuffer and CJPathEvaluateTyped for the selection
+	from the end (negative index, bound or step).
+*/
+#define CJPATH_BUFFER_MAX_TAIL 16
+
+/**
+	@brief The number of members or items is not known, the object or array is not valid JSON.
+*/
+#define CJPATH_COUNT_UNKNOWN ((size_t)-1)
+
+/**
+	@brief The extracted data with its type.
+*/
+typedef struct
+{
+	/**
+		@brief Extracted data.
+	*/
+	CJPathResult value;
+
+	/**
+		@brief Type of the value.
+	*/
+	CJPathValueType type;
+
+	/**
+		@brief Number of members or items of the object or array, CJPATH_COUNT_UNKNOWN if they cannot be read.
+		0 for other types.
+	*/
+	size_t childCount;
+
+} CJPathTypedResult;
+
 /**
 	@brief Processes the json patch and returns a list of pointers to the occurrences in the original string.
 	@param jsonData the string containing the JSON.
@@ -124,4 +411,581 @@ CJPathStatus CJPATH_API CJPathProcessing(const char* jsonData, size_t jsonDataLe
 */
 void CJPATH_API CJPathFreeList(CJPathList** resultList, MemFreeFunc memFreeFunc);
 
+/**
+	@brief Compiles the JSON path once to evaluate it many times without parsing the path.
+	@param jsonPath the string containing the JSON path.
+	@param jsonPathLen JSON path length.
+	@param compiled compiled JSON path, must be released by CJPathFreeCompiled.
+	@param memAllocFunc memory allocation function.
+	@return Instance of CJPathStatus.
+*/
+CJPathStatus CJPATH_API CJPathCompile(const char* jsonPath, size_t jsonPathLen, CJPathCompiled** compiled, MemAllocFunc memAllocFunc);
+
+/**
+	@brief Evaluates the compiled JSON path and returns a list of pointers to the occurrences in the original string.
+	@param jsonData the string containing the JSON.
+	@param jsonDataLen JSON data length.
+	@param compiled compiled JSON path.
+	@param resultList list containing extracted data.
+	@param memAllocFunc memory allocation function.
+	@param memFreeFunc memory release function.
+	@return Instance of CJPathStatus.
+*/
+CJPathStatus CJPATH_API CJPathEvaluate(const char* jsonData, size_t jsonDataLen, const CJPathCompiled* compiled,
+	CJPathList** resultList, MemAllocFunc memAllocFunc, MemFreeFunc memFreeFunc);
+
+/**
+	@brief Frees the memory allocated for the compiled JSON path.
+	@param compiled compiled JSON path.
+	@param memFreeFunc memory release function.
+*/
+void CJPATH_API CJPathFreeCompiled(CJPathCompiled** compiled, MemFreeFunc memFreeFunc);
+
+/**
+	@brief Processes the json patch and appends pointers to the occurrences in the original string to the array.
+	@param jsonData the string containing the JSON.
+	@param jsonDataLen JSON data length.
+	@param jsonPath the string containing the JSON path.
+	@param jsonPathLen JSON path length.
+	@param resultArray array containing extracted data.
+	@param memAllocFunc memory allocation function.
+	@param memFreeFunc memory release function.
+	@return Instance of CJPathStatus.
+*/
+CJPathStatus CJPATH_API CJPathProcessingArray(const char* jsonData, size_t jsonDataLen, const char* jsonPath,
+	size_t jsonPathLen, CJPathArray* resultArray, MemAllocFunc memAllocFunc, MemFreeFunc memFreeFunc);
+
+/**
+	@brief Evaluates the compiled JSON path and appends pointers to the occurrences in the original string to the array.
+	@param jsonData the string containing the JSON.
+	@param jsonDataLen JSON data length.
+	@param compiled compiled JSON path.
+	@param resultArray array containing extracted data.
+	@param memAllocFunc memory allocation function.
+	@param memFreeFunc memory release function.
+	@return Instance of CJPathStatus.
+*/
+CJPathStatus CJPATH_API CJPathEvaluateArray(const char* jsonData, size_t jsonDataLen, const CJPathCompiled* compiled,
+	CJPathArray* resultArray, MemAllocFunc memAllocFunc, MemFreeFunc memFreeFunc);
+
+/**
+	@brief Frees the memory allocated for the result array.
+	@param resultArray array containing extracted data.
+	@param memFreeFunc memory release function.
+*/
+void CJPATH_API CJPathFreeArray(CJPathArray* resultArray, MemFreeFunc memFreeFunc);
+
+/**
+	@brief Evaluates the compiled JSON path and stores the results to the buffer provided by the caller.
+	@details No memory is allocated. If the buffer is too small, the first capacity results are stored,
+	BUFFER_TOO_SMALL is returned and count contains the required number of items. Descendants (..) are searched
+	up to CJPATH_BUFFER_MAX_DEPTH nested levels and up to CJPATH_BUFFER_MAX_TAIL last items are kept for
+	the selection from the end (negative index, bound or step), LIMIT_EXCEEDED is returned otherwise.
+	@param jsonData the string containing the JSON.
+	@param jsonDataLen JSON data length.
+	@param compiled compiled JSON path.
+	@param results buffer for extracted data.
+	@param capacity number of items in the buffer.
+	@param count number of extracted items.
+	@return Instance of CJPathStatus.
+*/
+CJPathStatus CJPATH_API CJPathEvaluateBuffer(const char* jsonData, size_t jsonDataLen, const CJPathCompiled* compiled,
+	CJPathResult* results, size_t capacity, size_t* count);
+
+/**
+	@brief Evaluates the compiled JSON path and stores the results with their types to the buffer provided by the caller.
+	@details The buffer and the limits are the same as for CJPathEvaluateBuffer. The members or items of each stored
+	object or array are counted by one more pass over the value, the nested values are skipped.
+	@param jsonData the string containing the JSON.
+	@param jsonDataLen JSON data length.
+	@param compiled compiled JSON path.
+	@param results buffer for extracted data.
+	@param capacity number of items in the buffer.
+	@param count number of extracted items.
+	@return Instance of CJPathStatus.
+*/
+CJPathStatus CJPATH_API CJPathEvaluateTyped(const char* jsonData, size_t jsonDataLen, const CJPathCompiled* compiled,
+	CJPathTypedResult* results, size_t capacity, size_t* count);
+
+/**
+	@brief Evaluates the compiled JSON path and passes each result to the callback as soon as it is found.
+	@details The results are not stored. The callback returns STOPPED to stop the evaluation, the rest of the document
+	is not read. The work memory is the same as for CJPathFirst.
+	@param jsonData the string containing the JSON.
+	@param jsonDataLen JSON data length.
+	@param compiled compiled JSON path.
+	@param callback function receiving the extracted data.
+	@param userData pointer passed to the callback.
+	@return Instance of CJPathStatus, the status of the callback if it is not SUCCESS or STOPPED.
+*/
+CJPathStatus CJPATH_API CJPathEvaluateCallback(const char* jsonData, size_t jsonDataLen, const CJPathCompiled* compiled,
+	CJPathResultCallback callback, void* userData);
+
+/**
+	@brief Processes the json patch and passes each result to the callback as soon as it is found.
+	@details The JSON path is compiled into CJPATH_FOREACH_PATH_SIZE bytes on the stack. BUFFER_TOO_SMALL is returned
+	before any callback if the compiled path does not fit, such paths are compiled by CJPathCompile and evaluated
+	by CJPathEvaluateCallback. The evaluation is the same as for CJPathEvaluateCallback.
+	@param jsonData the string containing the JSON.
+	@param jsonDataLen JSON data length.
+	@param jsonPath the string containing the JSON path.
+	@param jsonPathLen JSON path length.
+	@param callback function receiving the extracted data.
+	@param userData pointer passed to the callback.
+	@return Instance of CJPathStatus, the status of the callback if it is not SUCCESS or STOPPED.
+*/
+CJPathStatus CJPATH_API CJPathForEach(const char* jsonData, size_t jsonDataLen, const char* jsonPath, size_t jsonPathLen,
+	CJPathResultCallback callback, void* userData);
+
+/**
+	@brief Evaluates the compiled JSON path up to the first result.
+	@details The evaluation stops at the first extracted value, the rest of the document is not read. No memory is allocated
+	unless descendants (..) are nested deeper than CJPATH_BUFFER_MAX_DEPTH levels or more than CJPATH_BUFFER_MAX_TAIL
+	last items are kept for the selection from the end, the work memory is then taken from the heap (malloc).
+	@param jsonData the string containing the JSON.
+	@param jsonDataLen JSON data length.
+	@param compiled compiled JSON path.
+	@param result first extracted data.
+	@return Instance of CJPathStatus.
+*/
+CJPathStatus CJPATH_API CJPathFirst(const char* jsonData, size_t jsonDataLen, const CJPathCompiled* compiled, CJPathResult* result);
+
+/**
+	@brief Checks whether the compiled JSON path selects any value.
+	@details The evaluation stops at the first extracted value, no result is stored. The work memory is the same
+	as for CJPathFirst.
+	@param jsonData the string containing the JSON.
+	@param jsonDataLen JSON data length.
+	@param compiled compiled JSON path.
+	@return Instance of CJPathStatus, SUCCESS if the value exists, NOT_FOUND otherwise.
+*/
+CJPathStatus CJPATH_API CJPathExists(const char* jsonData, size_t jsonDataLen, const CJPathCompiled* compiled);
+
+/**
+	@brief Counts the values selected by the compiled JSON path.
+	@details The results are only counted, not stored. The work memory is the same as for CJPathFirst.
+	@param jsonData the string containing the JSON.
+	@param jsonDataLen JSON data length.
+	@param compiled compiled JSON path.
+	@param count number of extracted items, 0 if the evaluation fails.
+	@return Instance of CJPathStatus, NOT_FOUND if no value is selected.
+*/
+CJPathStatus CJPATH_API CJPathCount(const char* jsonData, size_t jsonDataLen, const CJPathCompiled* compiled, size_t* count);
+
+/**
+	@brief Initializes the arena.
+	@param arena arena.
+	@param buffer memory used first, may be NULL.
+	@param bufferSize buffer size.
+	@param chunkSize size of chunks allocated when the buffer is exhausted, 0 for the default size.
+	@param memAllocFunc memory allocation function for chunks, NULL to use the buffer only.
+	@param memFreeFunc memory release function for chunks.
+	@return Instance of CJPathStatus.
+*/
+CJPathStatus CJPATH_API CJPathArenaInit(CJPathArena* arena, void* buffer, size_t bufferSize, size_t chunkSize,
+	MemAllocFunc memAllocFunc, MemFreeFunc memFreeFunc);
+
+/**
+	@brief Allocates memory from the arena.
+	@param arena arena.
+	@param size size of memory.
+	@return Pointer to memory or NULL.
+*/
+void* CJPATH_API CJPathArenaAlloc(CJPathArena* arena, size_t size);
+
+/**
+	@brief Releases all memory allocated from the arena, chunks are kept for reuse.
+	@param arena arena.
+*/
+void CJPATH_API CJPathArenaReset(CJPathArena* arena);
+
+/**
+	@brief Frees the chunks allocated by the arena.
+	@param arena arena.
+*/
+void CJPATH_API CJPathArenaDestroy(CJPathArena* arena);
+
+/**
+	@brief Processes the json patch using the arena for all allocations.
+	@details The results are valid until the arena is reset, the list must not be released by CJPathFreeList.
+	@param jsonData the string containing the JSON.
+	@param jsonDataLen JSON data length.
+	@param jsonPath the string containing the JSON path.
+	@param jsonPathLen JSON path length.
+	@param resultList list containing extracted data.
+	@param arena arena.
+	@return Instance of CJPathStatus.
+*/
+CJPathStatus CJPATH_API CJPathProcessingArena(const char* jsonData, size_t jsonDataLen, const char* jsonPath,
+	size_t jsonPathLen, CJPathList** resultList, CJPathArena* arena);
+
+/**
+	@brief Evaluates the compiled JSON path using the arena for all allocations.
+	@details The results are valid until the arena is reset, the list must not be released by CJPathFreeList.
+	@param jsonData the string containing the JSON.
+	@param jsonDataLen JSON data length.
+	@param compiled compiled JSON path.
+	@param resultList list containing extracted data.
+	@param arena arena.
+	@return Instance of CJPathStatus.
+*/
+CJPathStatus CJPATH_API CJPathEvaluateArena(const char* jsonData, size_t jsonDataLen, const CJPathCompiled* compiled,
+	CJPathList** resultList, CJPathArena* arena);
+
+/**
+	@brief Builds the structural index of the JSON document (SSE2/AVX2 are used if supported by the CPU).
+	@details The index refers to jsonData, which must not be changed or released while the index is used. Documents up to 4 GB are supported.
+	@param jsonData the string containing the JSON.
+	@param jsonDataLen JSON data length.
+	@param index structural index, must be released by CJPathFreeStructuralIndex.
+	@param memAllocFunc memory allocation function.
+	@param memFreeFunc memory release function.
+	@return Instance of CJPathStatus.
+*/
+CJPathStatus CJPATH_API CJPathBuildStructuralIndex(const char* jsonData, size_t jsonDataLen, CJPathStructuralIndex** index,
+	MemAllocFunc memAllocFunc, MemFreeFunc memFreeFunc);
+
+/**
+	@brief Evaluates the compiled JSON path using the structural index to skip objects, arrays and strings without scanning them.
+	@param index structural index of the JSON.
+	@param compiled compiled JSON path.
+	@param resultList list containing extracted data.
+	@param memAllocFunc memory allocation function.
+	@param memFreeFunc memory release function.
+	@return Instance of CJPathStatus.
+*/
+CJPathStatus CJPATH_API CJPathEvaluateIndexed(const CJPathStructuralIndex* index, const CJPathCompiled* compiled,
+	CJPathList** resultList, MemAllocFunc memAllocFunc, MemFreeFunc memFreeFunc);
+
+/**
+	@brief Frees the memory allocated for the structural index.
+	@param index structural index.
+	@param memFreeFunc memory release function.
+*/
+void CJPATH_API CJPathFreeStructuralIndex(CJPathStructuralIndex** index, MemFreeFunc memFreeFunc);
+
+/**
+	@brief Builds the index of the JSON document values.
+	@details The document is parsed once, the index refers to jsonData, which must not be changed or released while the index is used.
+	Documents up to 4 GB are supported.
+	@param jsonData the string containing the JSON.
+	@param jsonDataLen JSON data length.
+	@param index document index, must be released by CJPathFreeDocIndex.
+	@param memAllocFunc memory allocation function.
+	@param memFreeFunc memory release function.
+	@return Instance of CJPathStatus.
+*/
+CJPathStatus CJPATH_API CJPathBuildDocIndex(const char* jsonData, size_t jsonDataLen, CJPathDocIndex** index,
+	MemAllocFunc memAllocFunc, MemFreeFunc memFreeFunc);
+
+/**
+	@brief Evaluates the compiled JSON path using the document index, the JSON text is not scanned.
+	@details Members are found among the children of the object, array items are taken by index directly.
+	Indexes and slices give the items in the array order.
+	@param docIndex document index.
+	@param compiled compiled JSON path.
+	@param resultList list containing extracted data.
+	@param memAllocFunc memory allocation function.
+	@param memFreeFunc memory release function.
+	@return Instance of CJPathStatus.
+*/
+CJPathStatus CJPATH_API CJPathEvaluateDocIndex(const CJPathDocIndex* docIndex, const CJPathCompiled* compiled,
+	CJPathList** resultList, MemAllocFunc memAllocFunc, MemFreeFunc memFreeFunc);
+
+/**
+	@brief Evaluates the compiled JSON path using the document index, the results with their types are stored to the
+	buffer provided by the caller.
+	@details The number of members or items is known for all objects and arrays. No memory is allocated. If the buffer
+	is too small, the first capacity results are stored, BUFFER_TOO_SMALL is returned and count contains the required
+	number of items.
+	@param docIndex document index.
+	@param compiled compiled JSON path.
+	@param results buffer for extracted data.
+	@param capacity number of items in the buffer.
+	@param count number of extracted items.
+	@return Instance of CJPathStatus.
+*/
+CJPathStatus CJPATH_API CJPathEvaluateDocIndexTyped(const CJPathDocIndex* docIndex, const CJPathCompiled* compiled,
+	CJPathTypedResult* results, size_t capacity, size_t* count);
+
+/**
+	@brief Frees the memory allocated for the document index.
+	@param index document index.
+	@param memFreeFunc memory release function.
+*/
+void CJPATH_API CJPathFreeDocIndex(CJPathDocIndex** index, MemFreeFunc memFreeFunc);
+
+/**
+	@brief Merges the compiled JSON paths into a prefix tree, the common leading steps are evaluated once.
+	@details The compiled paths must not be released while the set is used. Paths with descendants (..) and items selected
+	from the end (negative index, bound or step) are not supported.
+	@param compiled array of compiled JSON paths.
+	@param compiledCount number of compiled JSON paths.
+	@param multi set of JSON paths, must be released by CJPathMultiFree.
+	@param memAllocFunc memory allocation function.
+	@return Instance of CJPathStatus.
+*/
+CJPathStatus CJPATH_API CJPathMultiCreate(const CJPathCompiled* const* compiled, size_t compiledCount, CJPathMulti** multi,
+	MemAllocFunc memAllocFunc);
+
+/**
+	@brief Evaluates all JSON paths of the set in one traversal of the JSON document.
+	@details The results of the path with index i are appended to resultArrays[i] in document order.
+	NOT_FOUND is returned if none of the paths is found.
+	@param jsonData the string containing the JSON.
+	@param jsonDataLen JSON data length.
+	@param multi set of JSON paths.
+	@param resultArrays arrays receiving extracted data, one per compiled path.
+	@param memAllocFunc memory allocation function.
+	@param memFreeFunc memory release function.
+	@return Instance of CJPathStatus.
+*/
+CJPathStatus CJPATH_API CJPathMultiEvaluate(const char* jsonData, size_t jsonDataLen, const CJPathMulti* multi,
+	CJPathArray* resultArrays, MemAllocFunc memAllocFunc, MemFreeFunc memFreeFunc);
+
+/**
+	@brief Frees the memory allocated for the set of JSON paths.
+	@param multi set of JSON paths.
+	@param memFreeFunc memory release function.
+*/
+void CJPATH_API CJPathMultiFree(CJPathMulti** multi, MemFreeFunc memFreeFunc);
+
+/**
+	@brief Evaluates the compiled JSON path for each record of the newline-delimited JSON (NDJSON, JSON Lines).
+	@details Blank lines are skipped. The records are split into contiguous ranges evaluated by threadCount threads,
+	the results are stored in input order. Memory functions must be thread-safe. The status of each record is stored
+	in the record, the function fails only if memory cannot be allocated.
+	@param jsonData the string containing the records.
+	@param jsonDataLen JSON data length.
+	@param compiled compiled JSON path.
+	@param threadCount number of threads including the calling thread, 0 or 1 to evaluate in the calling thread.
+	@param batch results of the records.
+	@param memAllocFunc memory allocation function.
+	@param memFreeFunc memory release function.
+	@return Instance of CJPathStatus.
+*/
+CJPathStatus CJPATH_API CJPathEvaluateBatch(const char* jsonData, size_t jsonDataLen, const CJPathCompiled* compiled, size_t threadCount,
+	CJPathBatch* batch, MemAllocFunc memAllocFunc, MemFreeFunc memFreeFunc);
+
+/**
+	@brief Frees the memory allocated for the batch results.
+	@param batch results of the records.
+	@param memFreeFunc memory release function.
+*/
+void CJPATH_API CJPathFreeBatch(CJPathBatch* batch, MemFreeFunc memFreeFunc);
+
+/**
+	@brief Evaluates the compiled JSON path over a large array by several threads.
+	@details The path must select the array items by a wildcard, a filter or a slice without the end bound in the first
+	step after the member names (example: $.records[*].amount, $.records[?(@.amount > 10)].id). The array is split into
+	parts at the commas between the items, the parts are taken by the threads, including the calling one, as they finish
+	the previous ones, and the results are appended to the array in document order. Other paths (indexes and bounded
+	slices stop after the last selected item) and small arrays are evaluated by the calling thread. Memory functions
+	must be thread-safe.
+	@param jsonData the string containing the JSON.
+	@param jsonDataLen JSON data length.
+	@param compiled compiled JSON path.
+	@param threadCount number of threads including the calling thread, 0 or 1 to evaluate in the calling thread.
+	@param resultArray array receiving extracted data.
+	@param memAllocFunc memory allocation function.
+	@param memFreeFunc memory release function.
+	@return Instance of CJPathStatus.
+*/
+CJPathStatus CJPATH_API CJPathEvaluateParallel(const char* jsonData, size_t jsonDataLen, const CJPathCompiled* compiled,
+	size_t threadCount, CJPathArray* resultArray, MemAllocFunc memAllocFunc, MemFreeFunc memFreeFunc);
+
+/**
+	@brief Creates the evaluation context.
+	@param context evaluation context, must be released by CJPathContextFree.
+	@param memAllocFunc memory allocation function.
+	@param memFreeFunc memory release function.
+	@return Instance of CJPathStatus.
+*/
+CJPathStatus CJPATH_API CJPathContextCreate(CJPathContext** context, MemAllocFunc memAllocFunc, MemFreeFunc memFreeFunc);
+
+/**
+	@brief Evaluates the compiled JSON path, the memory grown by the previous calls is reused.
+	@details The results are stored in the array of the context and are valid until the next call with the context.
+	@param context evaluation context.
+	@param jsonData the string containing the JSON.
+	@param jsonDataLen JSON data length.
+	@param compiled compiled JSON path.
+	@param resultArray array containing extracted data, owned by the context.
+	@return Instance of CJPathStatus.
+*/
+CJPathStatus CJPATH_API CJPathContextEvaluate(CJPathContext* context, const char* jsonData, size_t jsonDataLen,
+	const CJPathCompiled* compiled, const CJPathArray** resultArray);
+
+/**
+	@brief Compiles the JSON path to the memory of the context and evaluates it.
+	@details The results are stored in the array of the context and are valid until the next call with the context.
+	@param context evaluation context.
+	@param jsonData the string containing the JSON.
+	@param jsonDataLen JSON data length.
+	@param jsonPath the string containing the JSON path.
+	@param jsonPathLen JSON path length.
+	@param resultArray array containing extracted data, owned by the context.
+	@return Instance of CJPathStatus.
+*/
+CJPathStatus CJPATH_API CJPathContextProcessing(CJPathContext* context, const char* jsonData, size_t jsonDataLen,
+	const char* jsonPath, size_t jsonPathLen, const CJPathArray** resultArray);
+
+/**
+	@brief Frees the evaluation context and its buffers.
+	@param context evaluation context.
+*/
+void CJPATH_API CJPathContextFree(CJPathContext** context);
+
+/**
+	@brief Maps the JSON file to memory read-only, the file is not copied.
+	@param fileName file name.
+	@param file mapped file, must be released by CJPathUnmapFile.
+	@param memAllocFunc memory allocation function.
+	@return Instance of CJPathStatus.
+*/
+CJPathStatus CJPATH_API CJPathMapFile(const char* fileName, CJPathMappedFile** file, MemAllocFunc memAllocFunc);
+
+/**
+	@brief Returns the contents of the mapped file to be passed to any evaluation function.
+	@param file mapped file.
+	@param dataLen data length.
+	@return Pointer to the data.
+*/
+const char* CJPATH_API CJPathMappedFileData(const CJPathMappedFile* file, size_t* dataLen);
+
+/**
+	@brief Maps the JSON file to memory and processes the json patch.
+	@details On success the list refers to the mapping, which must be released by CJPathUnmapFile after the list.
+	On failure the file is unmapped.
+	@param fileName file name.
+	@param jsonPath the string containing the JSON path.
+	@param jsonPathLen JSON path length.
+	@param file mapped file.
+	@param resultList list containing extracted data.
+	@param memAllocFunc memory allocation function.
+	@param memFreeFunc memory release function.
+	@return Instance of CJPathStatus.
+*/
+CJPathStatus CJPATH_API CJPathProcessFile(const char* fileName, const char* jsonPath, size_t jsonPathLen, CJPathMappedFile** file,
+	CJPathList** resultList, MemAllocFunc memAllocFunc, MemFreeFunc memFreeFunc);
+
+/**
+	@brief Unmaps the file, the results referring to it become invalid.
+	@param file mapped file.
+	@param memFreeFunc memory release function.
+*/
+void CJPATH_API CJPathUnmapFile(CJPathMappedFile** file, MemFreeFunc memFreeFunc);
+
+/**
+	@brief Creates the streaming evaluator of the compiled JSON path.
+	@details The memory is allocated once and does not depend on the document size. The compiled path must not be
+	released while the evaluator is used. Paths with descendants (..), filters and items selected from the end (negative
+	index, bound or step) are not supported.
+	@param compiled compiled JSON path.
+	@param maxValueLen maximum length of the extracted value which is split between chunks and copied.
+	@param callback function receiving the extracted data in document order.
+	@param userData pointer passed to the callback.
+	@param stream streaming evaluator, must be released by CJPathStreamFree.
+	@param memAllocFunc memory allocation function.
+	@return Instance of CJPathStatus.
+*/
+CJPathStatus CJPATH_API CJPathStreamCreate(const CJPathCompiled* compiled, size_t maxValueLen, CJPathResultCallback callback,
+	void* userData, CJPathStream** stream, MemAllocFunc memAllocFunc);
+
+/**
+	@brief Passes the next chunk of the JSON document to the streaming evaluator.
+	@details The callback is called for each extracted value ending in the chunk. A value within the chunk points into the chunk,
+	a value split between chunks is copied. BUFFER_TOO_SMALL is returned if the copied value is longer than maxValueLen.
+	@param stream streaming evaluator.
+	@param chunk part of the JSON document.
+	@param chunkLen chunk length.
+	@return Instance of CJPathStatus.
+*/
+CJPathStatus CJPATH_API CJPathStreamFeed(CJPathStream* stream, const char* chunk, size_t chunkLen);
+
+/**
+	@brief Completes the evaluation after the last chunk.
+	@details INVALID_JSON is returned if the document is incomplete, NOT_FOUND if nothing was extracted.
+	@param stream streaming evaluator.
+	@return Instance of CJPathStatus.
+*/
+CJPathStatus CJPATH_API CJPathStreamFinish(CJPathStream* stream);
+
+/**
+	@brief Prepares the streaming evaluator for the next document.
+	@param stream streaming evaluator.
+*/
+void CJPATH_API CJPathStreamReset(CJPathStream* stream);
+
+/**
+	@brief Frees the memory allocated for the streaming evaluator.
+	@param stream streaming evaluator.
+	@param memFreeFunc memory release function.
+*/
+void CJPATH_API CJPathStreamFree(CJPathStream** stream, MemFreeFunc memFreeFunc);
+
+/**
+	@brief Returns the type of the extracted value by its first character.
+	@param result extracted data.
+	@return Instance of CJPathValueType, TYPE_INVALID for the empty result.
+*/
+CJPathValueType CJPATH_API CJPathResultType(const CJPathResult* result);
+
+/**
+	@brief Converts the extracted integer number without copying.
+	@param result extracted data.
+	@param value converted number.
+	@return Instance of CJPathStatus, INVALID_TYPE if the value is not an integer or does not fit into int64_t.
+*/
+CJPathStatus CJPATH_API CJPathGetInt64(const CJPathResult* result, int64_t* value);
+
+/**
+	@brief Converts the extracted number without copying.
+	@details The conversion is exact. The numbers of up to 19 significant digits with small exponents are computed
+	directly, the rest are converted by strtod.
+	@param result extracted data.
+	@param value converted number.
+	@return Instance of CJPathStatus, INVALID_TYPE if the value is not a number.
+*/
+CJPathStatus CJPATH_API CJPathGetDouble(const CJPathResult* result, double* value);
+
+/**
+	@brief Converts the extracted true or false.
+	@param result extracted data.
+	@param value converted value.
+	@return Instance of CJPathStatus, INVALID_TYPE if the value is not true or false.
+*/
+CJPathStatus CJPATH_API CJPathGetBool(const CJPathResult* result, bool* value);
+
+/**
+	@brief Copies the text of the extracted string without quotes, the escapes are decoded to UTF-8.
+	@details The text is terminated by zero. If the buffer is too small, nothing is copied, BUFFER_TOO_SMALL is returned
+	and textLen contains the required length without the terminating zero.
+	@param result extracted data.
+	@param buffer buffer receiving the text.
+	@param bufferSize size of the buffer.
+	@param textLen length of the text without the terminating zero.
+	@return Instance of CJPathStatus, INVALID_TYPE if the value is not a string, INVALID_JSON for the wrong escape.
+*/
+CJPathStatus CJPATH_API CJPathUnescapeInto(const CJPathResult* result, char* buffer, size_t bufferSize, size_t* textLen);
+
+/**
+	@brief Collects the statistics of the evaluations made by the calling thread.
+	@details The statistics are collected only if the library is built with CJPATH_STATS, otherwise the structure is
+	not changed. The structure is attached to the calling thread only (a thread-local pointer), the evaluations of
+	other threads are not counted, so each thread attaches its own structure and the structures are combined by
+	CJPathStatsMerge. CJPathEvaluateBatch and CJPathEvaluateParallel read the pointer of the calling thread when they
+	are called: their worker threads count to their own structures, which are added to that structure after the
+	workers are joined. The structure must not be used by other threads until the evaluation returns.
+	@param stats statistics of the thread, NULL stops the collection.
+*/
+void CJPATH_API CJPathStatsAttach(CJPathStats* stats);
+
+/**
+	@brief Adds the statistics to the total, the maximum depth is the maximum of both.
+	@param total combined statistics.
+	@param stats added statistics.
+*/
+void CJPATH_API CJPathStatsMerge(CJPathStats* total, const CJPathStats* stats);
+
 #endif // _CJPATH_H
\ No newline at end of file
@@ -0,0 +1,134 @@
+#include "CJPath_arena.h"
+#include "CJPath_stats.h"
+#include <stdint.h>
+#include <string.h>
+
+#define ARENA_ALIGNMENT 16
+#define ARENA_DEFAULT_CHUNK_SIZE 4096
+
+// Chunk allocated by memAllocFunc, the data follows the header
+typedef struct _ArenaChunk
+{
+	struct _ArenaChunk* next;
+	size_t size;
+} ArenaChunk;
+
+#define ARENA_CHUNK_HEADER_SIZE ((sizeof(ArenaChunk) + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1))
+
+static void useChunk(CJPathArena* arena, ArenaChunk* chunk)
+{
+	arena->currentChunk = chunk;
+	arena->buffer = (char*)chunk + ARENA_CHUNK_HEADER_SIZE;
+	arena->size = chunk->size;
+	arena->used = 0;
+}
+
+// Offset of the aligned block in the current buffer
+static size_t alignedOffset(const CJPathArena* arena)
+{
+	uintptr_t address;
+
+	if (arena->buffer == NULL)
+		return 0;
+
+	address = (uintptr_t)(arena->buffer + arena->used);
+	address = (address + ARENA_ALIGNMENT - 1) & ~(uintptr_t)(ARENA_ALIGNMENT - 1);
+
+	return (size_t)(address - (uintptr_t)arena->buffer);
+}
+
+CJPathStatus CJPathArenaInit(CJPathArena* arena, void* buffer, size_t bufferSize, size_t chunkSize,
+	MemAllocFunc memAllocFunc, MemFreeFunc memFreeFunc)
+{
+	if (arena == NULL || (buffer == NULL && bufferSize != 0) || ((memAllocFunc == NULL) != (memFreeFunc == NULL)))
+		return INVALID_ARGUMENT;
+
+	memset(arena, 0, sizeof(*arena));
+
+	arena->initialBuffer = (char*)buffer;
+	arena->initialSize = bufferSize;
+	arena->chunkSize = (chunkSize != 0) ? chunkSize : ARENA_DEFAULT_CHUNK_SIZE;
+	arena->memAllocFunc = memAllocFunc;
+	arena->memFreeFunc = memFreeFunc;
+
+	CJPathArenaReset(arena);
+
+	return SUCCESS;
+}
+
+void* CJPathArenaAlloc(CJPathArena* arena, size_t size)
+{
+	ArenaChunk* chunk;
+	size_t offset;
+
+	for (offset = alignedOffset(arena); offset > arena->size || arena->size - offset < size; offset = alignedOffset(arena))
+	{
+		chunk = (arena->currentChunk != NULL) ? ((ArenaChunk*)arena->currentChunk)->next : (ArenaChunk*)arena->firstChunk;
+
+		// Chunks are reused after reset, a new one is added after the last
+		if (chunk == NULL)
+		{
+			if (arena->memAllocFunc == NULL)
+				return NULL;
+
+			chunk = (ArenaChunk*)arena->memAllocFunc(ARENA_CHUNK_HEADER_SIZE + ((size > arena->chunkSize) ? size : arena->chunkSize));
+			if (chunk == NULL)
+				return NULL;
+
+			chunk->next = NULL;
+			chunk->size = (size > arena->chunkSize) ? size : arena->chunkSize;
+
+			if (arena->currentChunk != NULL)
+				((ArenaChunk*)arena->currentChunk)->next = chunk;
+			else
+				arena->firstChunk = chunk;
+		}
+
+		useChunk(arena, chunk);
+	}
+
+	arena->used = offset + size;
+
+	return arena->buffer + offset;
+}
+
+void CJPathArenaReset(CJPathArena* arena)
+{
+	arena->currentChunk = NULL;
+	arena->buffer = arena->initialBuffer;
+	arena->size = arena->initialSize;
+	arena->used = 0;
+}
+
+void CJPathArenaDestroy(CJPathArena* arena)
+{
+	ArenaChunk* chunk;
+	ArenaChunk* next;
+
+	for (chunk = (ArenaChunk*)arena->firstChunk; chunk != NULL; chunk = next)
+	{
+		next = chunk->next;
+		arena->memFreeFunc(chunk);
+	}
+
+	arena->firstChunk = NULL;
+	CJPathArenaReset(arena);
+}
+
+void* allocatorAlloc(const CJPathAllocator* allocator, size_t size)
+{
+	STATS_ADD(allocations, 1);
+	STATS_ADD(allocatedBytes, size);
+
+	if (allocator->arena != NULL)
+		return CJPathArenaAlloc(allocator->arena, size);
+
+	return allocator->memAllocFunc(size);
+}
+
+void allocatorFree(const CJPathAllocator* allocator, void* ptr)
+{
+	// Arena memory is released by reset
+	if (allocator->arena == NULL)
+		allocator->memFreeFunc(ptr);
+}
\ No newline at end of file
@@ -0,0 +1,17 @@
+#ifndef _CJPATH_ARENA_H
+#define _CJPATH_ARENA_H
+
+#include "CJPath.h"
+
+// Memory functions or arena used by the internal allocations
+typedef struct
+{
+	MemAllocFunc memAllocFunc;
+	MemFreeFunc memFreeFunc;
+	CJPathArena* arena;
+} CJPathAllocator;
+
+void* allocatorAlloc(const CJPathAllocator* allocator, size_t size);
+void allocatorFree(const CJPathAllocator* allocator, void* ptr);
+
+#endif // _CJPATH_ARENA_H
\ No newline at end of file
@@ -0,0 +1,249 @@
+#include "CJPath_internal.h"
+#include "CJPath_utils.h"
+#include "CJPath_thread.h"
+#include "CJPath_stats.h"
+#include <string.h>
+
+// Contiguous range of records evaluated by one thread
+typedef struct
+{
+	const CJPathCompiled* compiled;
+	CJPathRecordResult* records;
+	size_t recordCount;
+
+	// Results of the range, firstResult of the records is relative to this array
+	CJPathArray results;
+	CJPathStatus status;
+
+	MemAllocFunc memAllocFunc;
+	MemFreeFunc memFreeFunc;
+
+	CJPathThread thread;
+	bool started;
+
+#if defined(CJPATH_STATS)
+	// Statistics of the range, added to the statistics of the calling thread
+	CJPathStats stats;
+	CJPathStats* callerStats;
+#endif
+} BatchWorker;
+
+static bool isBlank(const char* ptr, const char* end)
+{
+	return (skipSpaces(ptr, end) == end);
+}
+
+// Splits the data into lines, blank lines are skipped. If records is NULL, only lines are counted.
+static size_t splitRecords(const char* jsonData, size_t jsonDataLen, CJPathRecordResult* records)
+{
+	const char* ptr;
+	const char* lineEnd;
+	const char* const end = jsonData + jsonDataLen;
+	size_t count;
+
+	for (ptr = jsonData, count = 0; ptr < end; ptr = lineEnd + 1)
+	{
+		lineEnd = strnchr('\n', ptr, (size_t)(end - ptr));
+		if (lineEnd == NULL)
+			lineEnd = end;
+
+		if (isBlank(ptr, lineEnd))
+			continue;
+
+		if (records != NULL)
+		{
+			records[count].record.strPtr = ptr;
+			records[count].record.strLen = (size_t)(lineEnd - ptr);
+		}
+
+		++count;
+	}
+
+	return count;
+}
+
+static void evaluateRecords(void* arg)
+{
+	BatchWorker* const worker = (BatchWorker*)arg;
+	CJPathRecordResult* record;
+	size_t i;
+#if defined(CJPATH_STATS)
+	CJPathStats* const threadCallerStats = threadStats;
+
+	threadStats = (worker->callerStats != NULL) ? &worker->stats : NULL;
+#endif
+
+	worker->status = SUCCESS;
+
+	for (i = 0; i < worker->recordCount; ++i)
+	{
+		record = &worker->records[i];
+		record->firstResult = worker->results.count;
+
+		record->status = CJPathEvaluateArray(record->record.strPtr, record->record.strLen, worker->compiled,
+			&worker->results, worker->memAllocFunc, worker->memFreeFunc);
+
+		record->resultCount = worker->results.count - record->firstResult;
+
+		if (record->status == BAD_ALLOC)
+			worker->status = BAD_ALLOC;
+	}
+
+#if defined(CJPATH_STATS)
+	threadStats = threadCallerStats;
+#endif
+}
+
+// Appends the results of the worker to the batch
+static CJPathStatus mergeResults(CJPathBatch* batch, BatchWorker* worker, const CJPathAllocator* allocator)
+{
+	CJPathResult* items;
+	size_t capacity, i;
+
+	if (batch->results.count + worker->results.count > batch->results.capacity)
+	{
+		for (capacity = (batch->results.capacity != 0) ? batch->results.capacity : 16;
+			capacity < batch->results.count + worker->results.count; capacity *= 2);
+
+		items = (CJPathResult*)allocatorAlloc(allocator, capacity * sizeof(CJPathResult));
+		if (items == NULL)
+			return BAD_ALLOC;
+
+		if (batch->results.items != NULL)
+		{
+			memcpy(items, batch->results.items, batch->results.count * sizeof(CJPathResult));
+			allocatorFree(allocator, batch->results.items);
+		}
+
+		batch->results.items = items;
+		batch->results.capacity = capacity;
+	}
+
+	if (worker->results.count != 0)
+		memcpy(batch->results.items + batch->results.count, worker->results.items, worker->results.count * sizeof(CJPathResult));
+
+	for (i = 0; i < worker->recordCount; ++i)
+		worker->records[i].firstResult += batch->results.count;
+
+	batch->results.count += worker->results.count;
+
+	return SUCCESS;
+}
+
+CJPathStatus CJPathEvaluateBatch(const char* jsonData, size_t jsonDataLen, const CJPathCompiled* compiled, size_t threadCount,
+	CJPathBatch* batch, MemAllocFunc memAllocFunc, MemFreeFunc memFreeFunc)
+{
+	CJPathStatus status;
+	CJPathAllocator allocator;
+	BatchWorker* workers;
+	size_t recordCount, first, i, limit;
+
+	if (jsonData == NULL || compiled == NULL || batch == NULL || memAllocFunc == NULL || memFreeFunc == NULL)
+		return INVALID_ARGUMENT;
+
+	allocator.memAllocFunc = memAllocFunc;
+	allocator.memFreeFunc = memFreeFunc;
+	allocator.arena = NULL;
+
+	batch->recordCount = 0;
+	batch->results.count = 0;
+
+	recordCount = splitRecords(jsonData, jsonDataLen, NULL);
+	if (recordCount == 0)
+		return SUCCESS;
+
+	// The records memory is kept for the next batch
+	if (recordCount > batch->recordCapacity)
+	{
+		if (batch->records != NULL)
+			memFreeFunc(batch->records);
+
+		batch->records = (CJPathRecordResult*)memAllocFunc(recordCount * sizeof(CJPathRecordResult));
+		batch->recordCapacity = (batch->records != NULL) ? recordCount : 0;
+		if (batch->records == NULL)
+			return BAD_ALLOC;
+	}
+
+	splitRecords(jsonData, jsonDataLen, batch->records);
+	batch->recordCount = recordCount;
+
+	if (threadCount == 0)
+		threadCount = 1;
+	if (threadCount > recordCount)
+		threadCount = recordCount;
+
+	workers = (BatchWorker*)memAllocFunc(threadCount * sizeof(BatchWorker));
+	if (workers == NULL)
+		return BAD_ALLOC;
+
+	// Ranges of about the same number of bytes
+	for (i = 0, first = 0; i < threadCount; ++i)
+	{
+		memset(&workers[i], 0, sizeof(BatchWorker));
+		workers[i].compiled = compiled;
+		workers[i].records = batch->records + first;
+		workers[i].memAllocFunc = memAllocFunc;
+		workers[i].memFreeFunc = memFreeFunc;
+#if defined(CJPATH_STATS)
+		workers[i].callerStats = threadStats;
+#endif
+
+		limit = (i + 1 == threadCount) ? jsonDataLen : jsonDataLen / threadCount * (i + 1);
+		for (; first < recordCount && (size_t)(batch->records[first].record.strPtr - jsonData) < limit; ++first)
+			++workers[i].recordCount;
+	}
+
+	// The first range is evaluated by the calling thread, a range is also evaluated here if the thread is not started
+	for (i = 1; i < threadCount; ++i)
+	{
+		if (workers[i].recordCount != 0)
+			workers[i].started = threadStart(&workers[i].thread, &evaluateRecords, &workers[i]);
+	}
+
+	for (i = 0; i < threadCount; ++i)
+	{
+		if (!workers[i].started)
+			evaluateRecords(&workers[i]);
+	}
+
+	status = SUCCESS;
+	for (i = 0; i < threadCount; ++i)
+	{
+		if (workers[i].started)
+			threadJoin(&workers[i].thread);
+
+#if defined(CJPATH_STATS)
+		CJPathStatsMerge(workers[i].callerStats, &workers[i].stats);
+#endif
+
+		if (workers[i].status != SUCCESS)
+			status = workers[i].status;
+
+		if (status == SUCCESS)
+			status = mergeResults(batch, &workers[i], &allocator);
+
+		CJPathFreeArray(&workers[i].results, memFreeFunc);
+	}
+
+	memFreeFunc(workers);
+
+	if (status != SUCCESS)
+	{
+		batch->recordCount = 0;
+		batch->results.count = 0;
+	}
+
+	return status;
+}
+
+void CJPathFreeBatch(CJPathBatch* batch, MemFreeFunc memFreeFunc)
+{
+	if (batch->records != NULL)
+		memFreeFunc(batch->records);
+
+	batch->records = NULL;
+	batch->recordCount = 0;
+	batch->recordCapacity = 0;
+
+	CJPathFreeArray(&batch->results, memFreeFunc);
+}
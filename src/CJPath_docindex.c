@@ -0,0 +1,526 @@
+#include "CJPath_internal.h"
+#include <stdint.h>
+#include <string.h>
+
+#define DOC_INITIAL_CAPACITY 64
+
+// Type of the indexed value
+typedef enum
+{
+	DOC_OBJECT,
+	DOC_ARRAY,
+	DOC_STRING,
+	DOC_NUMBER,
+	DOC_LITERAL // true, false, null
+} DocNodeType;
+
+// Value of the document, offsets are stored in 32 bits
+typedef struct
+{
+	uint32_t offset;
+	uint32_t length;
+
+	// Member name without quotes, for the members of the object
+	uint32_t keyOffset;
+	uint32_t keyLength;
+
+	// Children of the object or array are stored contiguously in the children array
+	uint32_t firstChild;
+	uint32_t childCount;
+
+	uint8_t type;
+} DocNode;
+
+struct _CJPathDocIndex
+{
+	const char* jsonData;
+	size_t jsonDataLen;
+
+	size_t nodeCount;
+	DocNode* nodes;
+
+	// Node indexes of the children of all objects and arrays
+	size_t childCount;
+	uint32_t* children;
+};
+
+// Object or array being read
+typedef struct
+{
+	uint32_t node;
+	size_t childBase;
+} DocFrame;
+
+// Growing arrays used while the index is built
+typedef struct
+{
+	CJPathDocIndex* index;
+	size_t nodeCapacity;
+	size_t childCapacity;
+
+	// Children of the open containers, moved to the children array when the container is closed
+	uint32_t* pending;
+	size_t pendingCount;
+	size_t pendingCapacity;
+
+	DocFrame* frames;
+	size_t frameCount;
+	size_t frameCapacity;
+
+	MemAllocFunc memAllocFunc;
+	MemFreeFunc memFreeFunc;
+} DocBuilder;
+
+// Evaluation state
+typedef struct
+{
+	const CJPathDocIndex* index;
+	const CJPathCompiled* compiled;
+	ResultSink* sink;
+	size_t resultCount;
+} DocEvalContext;
+
+// Makes room for the required number of items, the capacity grows twice
+static bool reserve(void** items, size_t* capacity, size_t count, size_t required, size_t itemSize, const DocBuilder* builder)
+{
+	void* ptr;
+	size_t newCapacity;
+
+	if (required <= *capacity)
+		return true;
+
+	for (newCapacity = (*capacity != 0) ? *capacity * 2 : DOC_INITIAL_CAPACITY; newCapacity < required; newCapacity *= 2);
+
+	ptr = builder->memAllocFunc(newCapacity * itemSize);
+	if (ptr == NULL)
+		return false;
+
+	if (*items != NULL)
+	{
+		memcpy(ptr, *items, count * itemSize);
+		builder->memFreeFunc(*items);
+	}
+
+	*items = ptr;
+	*capacity = newCapacity;
+
+	return true;
+}
+
+// Reads the member name and the colon, ptr points to the opening quote
+static CJPathStatus readKey(const char** ptr, const char* end, const char** key, size_t* keyLen)
+{
+	const char* keyEnd;
+
+	if (*ptr == end || (*ptr)[0] != '"')
+		return INVALID_JSON;
+
+	keyEnd = skipString(NULL, *ptr, end);
+	if (keyEnd == NULL)
+		return INVALID_JSON;
+
+	*key = *ptr + 1;
+	*keyLen = (size_t)(keyEnd - *ptr) - 2;
+
+	*ptr = skipSpaces(keyEnd, end);
+	if (*ptr == end || (*ptr)[0] != ':')
+		return INVALID_JSON;
+
+	*ptr = skipSpaces(*ptr + 1, end);
+
+	return SUCCESS;
+}
+
+// Adds the value starting at ptr, objects and arrays are left open
+static CJPathStatus addNode(DocBuilder* builder, const char** ptr, const char* end, const char* key, size_t keyLen)
+{
+	CJPathDocIndex* const index = builder->index;
+	CJPathStatus status;
+	CJPathResult value;
+	DocNode* node;
+	uint32_t nodeIdx;
+
+	if (*ptr == end)
+		return INVALID_JSON;
+
+	if (!reserve((void**)&index->nodes, &builder->nodeCapacity, index->nodeCount, index->nodeCount + 1, sizeof(DocNode), builder))
+		return BAD_ALLOC;
+
+	nodeIdx = (uint32_t)index->nodeCount++;
+	node = &index->nodes[nodeIdx];
+	memset(node, 0, sizeof(DocNode));
+	node->offset = (uint32_t)(*ptr - index->jsonData);
+
+	if (key != NULL)
+	{
+		node->keyOffset = (uint32_t)(key - index->jsonData);
+		node->keyLength = (uint32_t)keyLen;
+	}
+
+	if (builder->frameCount != 0)
+	{
+		if (!reserve((void**)&builder->pending, &builder->pendingCapacity, builder->pendingCount, builder->pendingCount + 1, sizeof(uint32_t), builder))
+			return BAD_ALLOC;
+
+		builder->pending[builder->pendingCount++] = nodeIdx;
+	}
+
+	if ((*ptr)[0] == '{' || (*ptr)[0] == '[')
+	{
+		node->type = ((*ptr)[0] == '{') ? DOC_OBJECT : DOC_ARRAY;
+
+		if (!reserve((void**)&builder->frames, &builder->frameCapacity, builder->frameCount, builder->frameCount + 1, sizeof(DocFrame), builder))
+			return BAD_ALLOC;
+
+		builder->frames[builder->frameCount].node = nodeIdx;
+		builder->frames[builder->frameCount].childBase = builder->pendingCount;
+		++builder->frameCount;
+
+		++*ptr;
+		return SUCCESS;
+	}
+
+	status = extractValue(NULL, *ptr, end, &value);
+	if (status != SUCCESS)
+		return status;
+
+	if ((*ptr)[0] == '"')
+		node->type = DOC_STRING;
+	else if (charIsNumberStart((*ptr)[0]))
+		node->type = DOC_NUMBER;
+	else
+		node->type = DOC_LITERAL;
+
+	node->length = (uint32_t)value.strLen;
+	*ptr += value.strLen;
+
+	return SUCCESS;
+}
+
+// Closes the top container, its children are moved from the pending stack
+static CJPathStatus closeNode(DocBuilder* builder, const char* ptr)
+{
+	CJPathDocIndex* const index = builder->index;
+	const DocFrame* const frame = &builder->frames[builder->frameCount - 1];
+	DocNode* const node = &index->nodes[frame->node];
+	const size_t count = builder->pendingCount - frame->childBase;
+
+	if (count != 0)
+	{
+		if (!reserve((void**)&index->children, &builder->childCapacity, index->childCount, index->childCount + count, sizeof(uint32_t), builder))
+			return BAD_ALLOC;
+
+		memcpy(index->children + index->childCount, builder->pending + frame->childBase, count * sizeof(uint32_t));
+	}
+
+	node->firstChild = (uint32_t)index->childCount;
+	node->childCount = (uint32_t)count;
+	node->length = (uint32_t)(ptr + 1 - index->jsonData) - node->offset;
+
+	index->childCount += count;
+	builder->pendingCount = frame->childBase;
+	--builder->frameCount;
+
+	return SUCCESS;
+}
+
+static CJPathStatus buildNodes(DocBuilder* builder)
+{
+	CJPathStatus status;
+	const DocNode* container;
+	const char* ptr;
+	const char* key;
+	const char* const end = builder->index->jsonData + builder->index->jsonDataLen;
+	size_t keyLen;
+	bool opened;
+
+	ptr = skipSpaces(builder->index->jsonData, end);
+	key = NULL;
+	keyLen = 0;
+
+	while (1)
+	{
+		status = addNode(builder, &ptr, end, key, keyLen);
+		if (status != SUCCESS)
+			return status;
+
+		opened = (builder->index->nodes[builder->index->nodeCount - 1].type <= DOC_ARRAY);
+
+		// Close the containers up to the next member or item
+		while (1)
+		{
+			ptr = skipSpaces(ptr, end);
+
+			if (builder->frameCount == 0)
+				return (ptr == end) ? SUCCESS : INVALID_JSON;
+
+			if (ptr == end)
+				return INVALID_JSON;
+
+			container = &builder->index->nodes[builder->frames[builder->frameCount - 1].node];
+
+			if (ptr[0] == ((container->type == DOC_OBJECT) ? '}' : ']'))
+			{
+				status = closeNode(builder, ptr);
+				if (status != SUCCESS)
+					return status;
+
+				++ptr;
+				opened = false;
+				continue;
+			}
+
+			if (!opened)
+			{
+				if (ptr[0] != ',')
+					return INVALID_JSON;
+				ptr = skipSpaces(ptr + 1, end);
+			}
+
+			break;
+		}
+
+		key = NULL;
+		if (container->type == DOC_OBJECT)
+		{
+			status = readKey(&ptr, end, &key, &keyLen);
+			if (status != SUCCESS)
+				return status;
+		}
+	}
+}
+
+CJPathStatus CJPathBuildDocIndex(const char* jsonData, size_t jsonDataLen, CJPathDocIndex** index,
+	MemAllocFunc memAllocFunc, MemFreeFunc memFreeFunc)
+{
+	CJPathStatus status;
+	DocBuilder builder;
+
+	if (jsonData == NULL || index == NULL || memAllocFunc == NULL || memFreeFunc == NULL)
+		return INVALID_ARGUMENT;
+
+	*index = NULL;
+
+	// Offsets are stored in 32 bits
+	if (jsonDataLen >= UINT32_MAX)
+		return INVALID_ARGUMENT;
+
+	memset(&builder, 0, sizeof(builder));
+	builder.memAllocFunc = memAllocFunc;
+	builder.memFreeFunc = memFreeFunc;
+
+	builder.index = (CJPathDocIndex*)memAllocFunc(sizeof(CJPathDocIndex));
+	if (builder.index == NULL)
+		return BAD_ALLOC;
+	memset(builder.index, 0, sizeof(CJPathDocIndex));
+
+	builder.index->jsonData = jsonData;
+	builder.index->jsonDataLen = jsonDataLen;
+
+	status = buildNodes(&builder);
+
+	if (builder.pending != NULL)
+		memFreeFunc(builder.pending);
+	if (builder.frames != NULL)
+		memFreeFunc(builder.frames);
+
+	if (status != SUCCESS)
+	{
+		CJPathFreeDocIndex(&builder.index, memFreeFunc);
+		return status;
+	}
+
+	*index = builder.index;
+
+	return SUCCESS;
+}
+
+void CJPathFreeDocIndex(CJPathDocIndex** index, MemFreeFunc memFreeFunc)
+{
+	if (index == NULL || *index == NULL)
+		return;
+
+	if ((*index)->nodes != NULL)
+		memFreeFunc((*index)->nodes);
+	if ((*index)->children != NULL)
+		memFreeFunc((*index)->children);
+	memFreeFunc(*index);
+
+	*index = NULL;
+}
+
+static CJPathStatus evaluateDocStep(DocEvalContext* ctx, size_t stepIdx, const DocNode* node);
+
+// Passes the node to the next step, or to the result after the last step
+static CJPathStatus evaluateDocNext(DocEvalContext* ctx, size_t stepIdx, uint32_t nodeIdx)
+{
+	const DocNode* const node = &ctx->index->nodes[nodeIdx];
+	CJPathResult result;
+
+	if (stepIdx + 1 == ctx->compiled->stepCount)
+	{
+		result.strPtr = ctx->index->jsonData + node->offset;
+		result.strLen = node->length;
+
+		ctx->sink->childCount = (node->type == DOC_OBJECT || node->type == DOC_ARRAY) ? node->childCount : 0;
+
+		++ctx->resultCount;
+		return ctx->sink->add(ctx->sink, &result);
+	}
+
+	return evaluateDocStep(ctx, stepIdx + 1, node);
+}
+
+// Applies the step to the children of the node
+static CJPathStatus applyDocStep(DocEvalContext* ctx, size_t stepIdx, const DocNode* node)
+{
+	CJPathStatus status;
+	const CJPathStep* const step = &ctx->compiled->steps[stepIdx];
+	const uint32_t* const children = ctx->index->children + node->firstChild;
+	const DocNode* child;
+	CJPathResult value;
+	ptrdiff_t pos, first, last;
+	size_t i, j;
+
+	switch (step->type)
+	{
+	case STEP_CHILD:
+		if (node->type != DOC_OBJECT)
+			return SUCCESS;
+
+		// Only the first member with the same name is taken
+		for (i = 0; i < step->count; ++i)
+		{
+			for (j = 0; j < node->childCount; ++j)
+			{
+				child = &ctx->index->nodes[children[j]];
+				if (child->keyLength == step->names[i].strLen
+					&& memcmp(ctx->index->jsonData + child->keyOffset, step->names[i].strPtr, child->keyLength) == 0)
+				{
+					status = evaluateDocNext(ctx, stepIdx, children[j]);
+					if (status != SUCCESS)
+						return status;
+					break;
+				}
+			}
+		}
+		return SUCCESS;
+
+	case STEP_WILDCARD:
+		if (node->type != DOC_OBJECT && node->type != DOC_ARRAY)
+			return SUCCESS;
+
+		for (i = 0; i < node->childCount; ++i)
+		{
+			status = evaluateDocNext(ctx, stepIdx, children[i]);
+			if (status != SUCCESS)
+				return status;
+		}
+		return SUCCESS;
+
+	// The predicate is checked on the item text
+	case STEP_FILTER:
+		if (node->type != DOC_OBJECT && node->type != DOC_ARRAY)
+			return SUCCESS;
+
+		for (i = 0; i < node->childCount; ++i)
+		{
+			child = &ctx->index->nodes[children[i]];
+			value.strPtr = ctx->index->jsonData + child->offset;
+			value.strLen = child->length;
+
+			if (!filterMatches(NULL, step, &value))
+				continue;
+
+			status = evaluateDocNext(ctx, stepIdx, children[i]);
+			if (status != SUCCESS)
+				return status;
+		}
+		return SUCCESS;
+
+	case STEP_INDEXES:
+		if (node->type != DOC_ARRAY)
+			return SUCCESS;
+
+		// The length is known, the items are checked in the array order
+		if (step->fromEnd)
+		{
+			for (i = 0; i < node->childCount; ++i)
+			{
+				if (!isTailIndexSelected(step, i, node->childCount))
+					continue;
+
+				status = evaluateDocNext(ctx, stepIdx, children[i]);
+				if (status != SUCCESS)
+					return status;
+			}
+			return SUCCESS;
+		}
+
+		// Indexes are sorted, the items are taken directly
+		for (i = 0; i < step->count && step->indexes[i] < node->childCount; ++i)
+		{
+			status = evaluateDocNext(ctx, stepIdx, children[step->indexes[i]]);
+			if (status != SUCCESS)
+				return status;
+		}
+		return SUCCESS;
+
+	case STEP_SLICE:
+		if (node->type != DOC_ARRAY)
+			return SUCCESS;
+
+		resolveSlice(step, node->childCount, &first, &last);
+		for (pos = first; (step->stepValue > 0) ? pos < last : pos > last; pos += step->stepValue)
+		{
+			status = evaluateDocNext(ctx, stepIdx, children[pos]);
+			if (status != SUCCESS)
+				return status;
+		}
+		return SUCCESS;
+	}
+
+	return SUCCESS;
+}
+
+static CJPathStatus evaluateDocStep(DocEvalContext* ctx, size_t stepIdx, const DocNode* node)
+{
+	CJPathStatus status;
+	const DocNode* const nodesEnd = ctx->index->nodes + ctx->index->nodeCount;
+	const DocNode* descendant;
+
+	if (!ctx->compiled->steps[stepIdx].recursive)
+		return applyDocStep(ctx, stepIdx, node);
+
+	// Nodes are stored in document order, the descendants follow the node up to its end offset
+	for (descendant = node; descendant != nodesEnd
+		&& (descendant == node || descendant->offset < node->offset + node->length); ++descendant)
+	{
+		if (descendant->type != DOC_OBJECT && descendant->type != DOC_ARRAY)
+			continue;
+
+		status = applyDocStep(ctx, stepIdx, descendant);
+		if (status != SUCCESS)
+			return status;
+	}
+
+	return SUCCESS;
+}
+
+CJPathStatus evaluateDocIndex(const CJPathDocIndex* docIndex, const CJPathCompiled* compiled, ResultSink* sink)
+{
+	CJPathStatus status;
+	DocEvalContext ctx;
+
+	ctx.index = docIndex;
+	ctx.compiled = compiled;
+	ctx.sink = sink;
+	ctx.resultCount = 0;
+
+	status = evaluateDocStep(&ctx, 0, &docIndex->nodes[0]);
+
+	if (status == SUCCESS && !ctx.resultCount)
+		status = NOT_FOUND;
+
+	return status;
+}
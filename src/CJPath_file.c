@@ -0,0 +1,204 @@
+#if !defined(_WIN32)
+#define _DEFAULT_SOURCE
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "CJPath.h"
+#include <string.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+struct _CJPathMappedFile
+{
+	const char* data;
+	size_t dataLen;
+
+#if defined(_WIN32)
+	HANDLE file;
+	HANDLE mapping;
+#endif
+};
+
+#if defined(_WIN32)
+
+static CJPathStatus mapFile(const char* fileName, CJPathMappedFile* mapped)
+{
+	LARGE_INTEGER size;
+
+	mapped->file = CreateFileA(fileName, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (mapped->file == INVALID_HANDLE_VALUE)
+		return IO_ERROR;
+
+	if (!GetFileSizeEx(mapped->file, &size) || (unsigned long long)size.QuadPart > (size_t)-1)
+	{
+		CloseHandle(mapped->file);
+		return IO_ERROR;
+	}
+
+	// Empty file cannot be mapped
+	if (size.QuadPart == 0)
+	{
+		CloseHandle(mapped->file);
+		return INVALID_JSON;
+	}
+
+	mapped->mapping = CreateFileMappingA(mapped->file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (mapped->mapping == NULL)
+	{
+		CloseHandle(mapped->file);
+		return IO_ERROR;
+	}
+
+	mapped->data = (const char*)MapViewOfFile(mapped->mapping, FILE_MAP_READ, 0, 0, 0);
+	if (mapped->data == NULL)
+	{
+		CloseHandle(mapped->mapping);
+		CloseHandle(mapped->file);
+		return IO_ERROR;
+	}
+
+	mapped->dataLen = (size_t)size.QuadPart;
+
+	return SUCCESS;
+}
+
+static void unmapFile(CJPathMappedFile* mapped)
+{
+	UnmapViewOfFile(mapped->data);
+	CloseHandle(mapped->mapping);
+	CloseHandle(mapped->file);
+}
+
+#else
+
+static CJPathStatus mapFile(const char* fileName, CJPathMappedFile* mapped)
+{
+	struct stat info;
+	void* data;
+	int fd;
+
+	fd = open(fileName, O_RDONLY);
+	if (fd < 0)
+		return IO_ERROR;
+
+	if (fstat(fd, &info) != 0 || (unsigned long long)info.st_size > (size_t)-1)
+	{
+		close(fd);
+		return IO_ERROR;
+	}
+
+	// Empty file cannot be mapped
+	if (info.st_size == 0)
+	{
+		close(fd);
+		return INVALID_JSON;
+	}
+
+	data = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+	// The mapping is kept after the descriptor is closed
+	close(fd);
+
+	if (data == MAP_FAILED)
+		return IO_ERROR;
+
+	// The document is read from the beginning to the end, the hints are optional
+	posix_madvise(data, (size_t)info.st_size, POSIX_MADV_SEQUENTIAL);
+#if defined(MADV_HUGEPAGE)
+	madvise(data, (size_t)info.st_size, MADV_HUGEPAGE);
+#endif
+
+	mapped->data = (const char*)data;
+	mapped->dataLen = (size_t)info.st_size;
+
+	return SUCCESS;
+}
+
+static void unmapFile(CJPathMappedFile* mapped)
+{
+	munmap((void*)mapped->data, mapped->dataLen);
+}
+
+#endif
+
+CJPathStatus CJPathMapFile(const char* fileName, CJPathMappedFile** file, MemAllocFunc memAllocFunc)
+{
+	CJPathStatus status;
+	CJPathMappedFile mapped;
+
+	if (fileName == NULL || file == NULL || memAllocFunc == NULL)
+		return INVALID_ARGUMENT;
+
+	*file = NULL;
+
+	memset(&mapped, 0, sizeof(mapped));
+
+	status = mapFile(fileName, &mapped);
+	if (status != SUCCESS)
+		return status;
+
+	*file = (CJPathMappedFile*)memAllocFunc(sizeof(CJPathMappedFile));
+	if (*file == NULL)
+	{
+		unmapFile(&mapped);
+		return BAD_ALLOC;
+	}
+
+	memcpy(*file, &mapped, sizeof(mapped));
+
+	return SUCCESS;
+}
+
+const char* CJPathMappedFileData(const CJPathMappedFile* file, size_t* dataLen)
+{
+	if (file == NULL)
+	{
+		if (dataLen != NULL)
+			*dataLen = 0;
+		return NULL;
+	}
+
+	if (dataLen != NULL)
+		*dataLen = file->dataLen;
+
+	return file->data;
+}
+
+CJPathStatus CJPathProcessFile(const char* fileName, const char* jsonPath, size_t jsonPathLen, CJPathMappedFile** file,
+	CJPathList** resultList, MemAllocFunc memAllocFunc, MemFreeFunc memFreeFunc)
+{
+	CJPathStatus status;
+
+	if (fileName == NULL || jsonPath == NULL || file == NULL || resultList == NULL || memAllocFunc == NULL || memFreeFunc == NULL)
+		return INVALID_ARGUMENT;
+
+	status = CJPathMapFile(fileName, file, memAllocFunc);
+	if (status != SUCCESS)
+		return status;
+
+	status = CJPathProcessing((*file)->data, (*file)->dataLen, jsonPath, jsonPathLen, resultList, memAllocFunc, memFreeFunc);
+
+	// Results refer to the mapping, it is released only if there are no results
+	if (status != SUCCESS)
+		CJPathUnmapFile(file, memFreeFunc);
+
+	return status;
+}
+
+void CJPathUnmapFile(CJPathMappedFile** file, MemFreeFunc memFreeFunc)
+{
+	if (file == NULL || *file == NULL)
+		return;
+
+	unmapFile(*file);
+
+	memFreeFunc(*file);
+	*file = NULL;
+}
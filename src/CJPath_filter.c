@@ -0,0 +1,286 @@
+#include "CJPath_internal.h"
+#include "CJPath_utils.h"
+#include <string.h>
+
+// Converts the number literal of the filter, returns false if the text is not a number
+static bool parseNumber(const char* ptr, const char* end, double* value, const char** numberEnd)
+{
+	size_t len;
+
+	for (len = 0; ptr + len != end && charIsNumberPart(ptr[len]); ++len);
+
+	if (len == 0 || !numberToDouble(ptr, len, value))
+		return false;
+
+	*numberEnd = ptr + len;
+	return true;
+}
+
+static bool charIsNameEnd(const char value)
+{
+	return (charIsSpace(value) || strchr(".[()!=<>&|", value) != NULL);
+}
+
+// Relative path of the compared value (example: @.name['other name'])
+static CJPathStatus compileOperand(const char** ptr, const char* end, CompileBuilder* builder, CJPathFilterTerm* term)
+{
+	const char* name;
+	const char* nameEnd;
+	const char* next;
+
+	if (*ptr == end || (*ptr)[0] != '@')
+		return INVALID_JSON_PATH;
+	++(*ptr); // by pass @
+
+	term->names = (builder->names != NULL) ? builder->names + builder->nameCount : NULL;
+
+	while (*ptr != end)
+	{
+		if ((*ptr)[0] == '.')
+		{
+			name = *ptr + 1;
+			for (nameEnd = name; nameEnd != end && !charIsNameEnd(nameEnd[0]); ++nameEnd);
+			next = nameEnd;
+		}
+		else if ((*ptr)[0] == '[')
+		{
+			name = skipSpaces(*ptr + 1, end);
+			if (name == end || name[0] != '\'')
+				return INVALID_JSON_PATH;
+			++name; // by pass '
+
+			nameEnd = strnchr('\'', name, (size_t)(end - name));
+			if (nameEnd == NULL)
+				return INVALID_JSON_PATH;
+
+			next = skipSpaces(nameEnd + 1, end);
+			if (next == end || next[0] != ']')
+				return INVALID_JSON_PATH;
+			++next; // by pass ]
+		}
+		else
+			break;
+
+		if (nameEnd == name)
+			return INVALID_JSON_PATH;
+
+		addName(builder, name, (size_t)(nameEnd - name));
+		++term->nameCount;
+
+		*ptr = next;
+	}
+
+	return SUCCESS;
+}
+
+static CJPathFilterOp compileOp(const char** ptr, const char* end)
+{
+	static const struct
+	{
+		const char* text;
+		CJPathFilterOp op;
+	} ops[] = {
+		{ "==", FILTER_EQ }, { "!=", FILTER_NE }, { "<=", FILTER_LE }, { ">=", FILTER_GE }, { "<", FILTER_LT }, { ">", FILTER_GT }
+	};
+	size_t i;
+
+	for (i = 0; i < sizeof(ops) / sizeof(ops[0]); ++i)
+	{
+		if (isLiteral(*ptr, end, ops[i].text, strlen(ops[i].text)))
+		{
+			*ptr += strlen(ops[i].text);
+			return ops[i].op;
+		}
+	}
+
+	return FILTER_EXISTS;
+}
+
+// Compared value (example: 10, 'text', "text", true, null)
+static CJPathStatus compileLiteral(const char** ptr, const char* end, CompileBuilder* builder, CJPathFilterTerm* term)
+{
+	static const char* const tokens[] = { JSON_VALUE_TRUE, JSON_VALUE_FALSE, JSON_VALUE_NULL };
+	const char* textEnd;
+	size_t i;
+
+	if (*ptr == end)
+		return INVALID_JSON_PATH;
+
+	if ((*ptr)[0] == '\'' || (*ptr)[0] == '"')
+	{
+		textEnd = strnchr((*ptr)[0], *ptr + 1, (size_t)(end - *ptr - 1));
+		if (textEnd == NULL)
+			return INVALID_JSON_PATH;
+
+		term->literalType = LITERAL_STRING;
+		term->text.strPtr = addChars(builder, *ptr + 1, (size_t)(textEnd - *ptr - 1));
+		term->text.strLen = (size_t)(textEnd - *ptr - 1);
+
+		*ptr = textEnd + 1;
+		return SUCCESS;
+	}
+
+	for (i = 0; i < sizeof(tokens) / sizeof(tokens[0]); ++i)
+	{
+		if (isLiteral(*ptr, end, tokens[i], strlen(tokens[i])))
+		{
+			// Tokens are equal or not equal only
+			if (term->op != FILTER_EQ && term->op != FILTER_NE)
+				return INVALID_JSON_PATH;
+
+			term->literalType = LITERAL_TOKEN;
+			term->text.strPtr = tokens[i];
+			term->text.strLen = strlen(tokens[i]);
+
+			*ptr += term->text.strLen;
+			return SUCCESS;
+		}
+	}
+
+	term->literalType = LITERAL_NUMBER;
+	if (!parseNumber(*ptr, end, &term->number, ptr))
+		return INVALID_JSON_PATH;
+
+	return SUCCESS;
+}
+
+CJPathStatus compileFilter(const char** ptr, const char* end, CompileBuilder* builder, CJPathStep* step)
+{
+	CJPathStatus status;
+	CJPathFilterTerm term;
+	const char* cur;
+
+	step->type = STEP_FILTER;
+
+	cur = skipSpaces(*ptr + 1, end); // by pass [
+	if (cur == end || cur[0] != '?')
+		return INVALID_JSON_PATH;
+
+	cur = skipSpaces(cur + 1, end);
+	if (cur == end || cur[0] != '(')
+		return INVALID_JSON_PATH;
+
+	while (1)
+	{
+		memset(&term, 0, sizeof(term));
+
+		cur = skipSpaces(cur + 1, end); // by pass ( or the second char of && and ||
+		status = compileOperand(&cur, end, builder, &term);
+		if (status != SUCCESS)
+			return status;
+
+		cur = skipSpaces(cur, end);
+		term.op = compileOp(&cur, end);
+		if (term.op != FILTER_EXISTS)
+		{
+			cur = skipSpaces(cur, end);
+			status = compileLiteral(&cur, end, builder, &term);
+			if (status != SUCCESS)
+				return status;
+
+			cur = skipSpaces(cur, end);
+		}
+
+		if (isLiteral(cur, end, "||", 2))
+			term.orNext = true;
+		else if (!isLiteral(cur, end, "&&", 2))
+			break;
+
+		addFilterTerm(builder, &term);
+		++step->count;
+		++cur; // by pass the first char of && or ||
+	}
+
+	addFilterTerm(builder, &term);
+	++step->count;
+
+	if (cur == end || cur[0] != ')')
+		return INVALID_JSON_PATH;
+
+	cur = skipSpaces(cur + 1, end);
+	if (cur == end || cur[0] != ']')
+		return INVALID_JSON_PATH;
+
+	*ptr = cur + 1;
+	return SUCCESS;
+}
+
+static int compareText(const char* text, size_t textLen, const CJPathResult* literal)
+{
+	int cmp;
+
+	cmp = memcmp(text, literal->strPtr, (textLen < literal->strLen) ? textLen : literal->strLen);
+	if (cmp != 0)
+		return cmp;
+
+	return (textLen > literal->strLen) - (textLen < literal->strLen);
+}
+
+// Returns true if the value is compared with the literal and the comparison holds
+static bool termMatches(const CJPathStructuralIndex* structural, const CJPathFilterTerm* term, const CJPathResult* item)
+{
+	CJPathResult value;
+	double number;
+	int cmp;
+	size_t i;
+
+	for (value = *item, i = 0; i < term->nameCount; ++i)
+	{
+		if (processingPath(structural, &term->names[i], value.strPtr, value.strLen, &value) != SUCCESS)
+			return false;
+	}
+
+	if (term->op == FILTER_EXISTS)
+		return true;
+
+	switch (term->literalType)
+	{
+	case LITERAL_NUMBER:
+		if (!numberToDouble(value.strPtr, value.strLen, &number))
+			return (term->op == FILTER_NE);
+		cmp = (number > term->number) - (number < term->number);
+		break;
+
+	// Raw string content is compared, escapes are not decoded
+	case LITERAL_STRING:
+		if (value.strPtr[0] != '"')
+			return (term->op == FILTER_NE);
+		cmp = compareText(value.strPtr + 1, value.strLen - 2, &term->text);
+		break;
+
+	default:
+		cmp = (value.strLen == term->text.strLen && memcmp(value.strPtr, term->text.strPtr, value.strLen) == 0) ? 0 : 1;
+		break;
+	}
+
+	switch (term->op)
+	{
+	case FILTER_EQ: return (cmp == 0);
+	case FILTER_NE: return (cmp != 0);
+	case FILTER_LT: return (cmp < 0);
+	case FILTER_LE: return (cmp <= 0);
+	case FILTER_GT: return (cmp > 0);
+	default:        return (cmp >= 0);
+	}
+}
+
+// The terms are evaluated as groups joined by ||, the terms of a group are joined by &&
+bool filterMatches(const CJPathStructuralIndex* structural, const CJPathStep* step, const CJPathResult* value)
+{
+	bool matched;
+	size_t i;
+
+	for (i = 0, matched = true; i < step->count; ++i)
+	{
+		matched = matched && termMatches(structural, &step->terms[i], value);
+
+		if (step->terms[i].orNext || i + 1 == step->count)
+		{
+			if (matched)
+				return true;
+			matched = true;
+		}
+	}
+
+	return false;
+}
@@ -0,0 +1,186 @@
+#ifndef _CJPATH_INTERNAL_H
+#define _CJPATH_INTERNAL_H
+
+#include "CJPath.h"
+#include "CJPath_arena.h"
+#include <stddef.h>
+#include <stdint.h>
+
+#define JSON_VALUE_TRUE      "true"
+#define JSON_VALUE_TRUE_LEN  (sizeof(JSON_VALUE_TRUE)-1)
+
+#define JSON_VALUE_FALSE     "false"
+#define JSON_VALUE_FALSE_LEN (sizeof(JSON_VALUE_FALSE)-1)
+
+#define JSON_VALUE_NULL      "null"
+#define JSON_VALUE_NULL_LEN  (sizeof(JSON_VALUE_NULL)-1)
+
+/**
+	@brief Type of the compiled JSON path step.
+*/
+typedef enum _CJPathStepType
+{
+	STEP_CHILD,    // .name or ['name' (, 'name')]
+	STEP_INDEXES,  // [index (, index)], negative indexes are counted from the end
+	STEP_SLICE,    // [start:end:step]
+	STEP_WILDCARD, // .* or [*]
+	STEP_FILTER    // [?(@.name op value)]
+} CJPathStepType;
+
+/**
+	@brief Comparison of the filter term.
+*/
+typedef enum _CJPathFilterOp
+{
+	FILTER_EXISTS, // @.name
+	FILTER_EQ,     // ==
+	FILTER_NE,     // !=
+	FILTER_LT,     // <
+	FILTER_LE,     // <=
+	FILTER_GT,     // >
+	FILTER_GE      // >=
+} CJPathFilterOp;
+
+/**
+	@brief Type of the literal compared by the filter term.
+*/
+typedef enum _CJPathLiteralType
+{
+	LITERAL_NUMBER,
+	LITERAL_STRING, // 'text' or "text"
+	LITERAL_TOKEN   // true, false, null
+} CJPathLiteralType;
+
+/**
+	@brief One comparison of the filter, the terms are joined by && and ||.
+*/
+typedef struct
+{
+	// Relative path of the compared value (@.name.name), no names for the item itself
+	size_t nameCount;
+	const CJPathResult* names;
+
+	CJPathFilterOp op;
+
+	// Number value, or the string without quotes or the token text
+	CJPathLiteralType literalType;
+	double number;
+	CJPathResult text;
+
+	// The next term is joined by || (&& has higher precedence)
+	bool orNext;
+} CJPathFilterTerm;
+
+/**
+	@brief One step of the compiled JSON path.
+*/
+typedef struct
+{
+	CJPathStepType type;
+
+	// Descendants by .., the step is applied to the value and all nested values
+	bool recursive;
+
+	// Number of names (STEP_CHILD), indexes (STEP_INDEXES) or filter terms (STEP_FILTER)
+	size_t count;
+
+	// Child names
+	const CJPathResult* names;
+
+	// Array indexes, sorted without duplicates
+	const size_t* indexes;
+
+	// Negative indexes as distances from the end (1 - the last item), sorted without duplicates
+	size_t tailCount;
+	const size_t* tailIndexes;
+
+	// Filter terms
+	const CJPathFilterTerm* terms;
+
+	// Slice bounds, negative bounds are counted from the end. The missing bounds are PTRDIFF_MAX or PTRDIFF_MIN.
+	ptrdiff_t fromValue;
+	ptrdiff_t toValue;
+	ptrdiff_t stepValue;
+
+	// The selection depends on the array length (negative index, bound or step)
+	bool fromEnd;
+} CJPathStep;
+
+struct _CJPathCompiled
+{
+	size_t stepCount;
+	const CJPathStep* steps;
+};
+
+// Collects the compiled steps. If steps is NULL, only sizes are counted.
+typedef struct
+{
+	CJPathStep* steps;
+	CJPathResult* names;
+	CJPathFilterTerm* terms;
+	size_t* indexes;
+	char* chars;
+
+	size_t stepCount;
+	size_t nameCount;
+	size_t termCount;
+	size_t indexCount;
+	size_t charCount;
+} CompileBuilder;
+
+// Path compiler (CJPath.c), the text is copied only when steps is set
+const char* addChars(CompileBuilder* builder, const char* text, size_t textLen);
+void addName(CompileBuilder* builder, const char* name, size_t nameLen);
+void addFilterTerm(CompileBuilder* builder, const CJPathFilterTerm* term);
+CJPathStatus processingPath(const CJPathStructuralIndex* structural, const CJPathResult* name, const char* jsonData,
+	size_t jsonDataLen, CJPathResult* result);
+
+// Filter expressions (CJPath_filter.c)
+CJPathStatus compileFilter(const char** ptr, const char* end, CompileBuilder* builder, CJPathStep* step);
+bool filterMatches(const CJPathStructuralIndex* structural, const CJPathStep* step, const CJPathResult* value);
+
+// Returned by the result sink to stop the evaluation after the required results, the evaluation succeeds
+#define EVALUATION_STOPPED ((CJPathStatus)(LIMIT_EXCEEDED + 1))
+
+// Receives the extracted values
+typedef struct _ResultSink ResultSink;
+struct _ResultSink
+{
+	CJPathStatus(*add)(ResultSink* sink, const CJPathResult* result);
+
+	// Number of members or items of the added value, set by the document index evaluation before add
+	size_t childCount;
+};
+
+// Appends the result to the end of the array, the capacity grows twice
+CJPathStatus appendResultToArray(CJPathArray* array, const CJPathResult* result, const CJPathAllocator* allocator);
+
+// Evaluates the array step and the following steps for the array part, jsonData points to [ or , before the first item
+CJPathStatus evaluateArrayRange(const CJPathCompiled* compiled, size_t stepIdx, const char* jsonData, const char* end,
+	size_t firstIndex, CJPathArray* resultArray, const CJPathAllocator* allocator);
+
+// Scanning primitives (CJPath_scan.c)
+bool charIsIntegerNum(const char value);
+bool charIsSpace(const char value);
+const char* skipSpaces(const char* ptr, const char* end);
+bool isLiteral(const char* ptr, const char* end, const char* literal, size_t literalLen);
+const char* skipString(const CJPathStructuralIndex* structural, const char* ptr, const char* end);
+const char* skipContainer(const CJPathStructuralIndex* structural, const char* ptr, const char* end);
+bool charIsNumberStart(const char value);
+bool charIsNumberPart(const char value);
+bool isValueStart(const char* ptr, const char* end);
+CJPathStatus extractValue(const CJPathStructuralIndex* structural, const char* ptr, const char* end, CJPathResult* result);
+CJPathStatus nextMember(const CJPathStructuralIndex* structural, const char** ptr, const char* end, CJPathResult* key, CJPathResult* value);
+CJPathStatus nextArrayItem(const CJPathStructuralIndex* structural, const char** ptr, const char* end, CJPathResult* value);
+bool isArrayEnd(const char* start, const char* ptr, const char* end);
+bool isIndexSelected(const CJPathStep* step, size_t index);
+void resolveSlice(const CJPathStep* step, size_t length, ptrdiff_t* first, ptrdiff_t* last);
+bool isTailIndexSelected(const CJPathStep* step, size_t index, size_t length);
+
+// Converts the JSON number independently of the locale, returns false if the text is not a number (CJPath_value.c)
+bool numberToDouble(const char* ptr, size_t len, double* value);
+
+// Evaluation against the document index (CJPath_docindex.c)
+CJPathStatus evaluateDocIndex(const CJPathDocIndex* docIndex, const CJPathCompiled* compiled, ResultSink* sink);
+
+#endif // _CJPATH_INTERNAL_H
@@ -0,0 +1,428 @@
+#include "CJPath_internal.h"
+#include <stdint.h>
+#include <string.h>
+
+#define MULTI_NONE SIZE_MAX
+
+// Node of the prefix tree, the root node has no step
+typedef struct
+{
+	const CJPathStep* step;
+
+	size_t firstChild;
+	size_t nextSibling;
+
+	// Paths ending at this node (list linked by pathNext)
+	size_t firstPath;
+	size_t lastPath;
+
+	// Children names are marked as found in the flags starting at nameBase
+	size_t nameBase;
+	size_t nameCount;
+
+	// Children applicable to objects and arrays
+	bool objectChildren;
+	bool arrayChildren;
+	bool hasWildcard;
+
+	// Highest array index required by the children (MULTI_NONE - all items)
+	size_t arrayLimit;
+} MultiNode;
+
+struct _CJPathMulti
+{
+	size_t pathCount;
+	size_t nodeCount;
+	size_t nameCount;
+	MultiNode* nodes;
+	size_t* pathNext;
+};
+
+// Evaluation state
+typedef struct
+{
+	const CJPathMulti* multi;
+	CJPathArray* resultArrays;
+	const CJPathAllocator* allocator;
+	bool* nameFound;
+	size_t resultCount;
+} MultiContext;
+
+static bool stepsEqual(const CJPathStep* first, const CJPathStep* second)
+{
+	size_t i;
+
+	if (first->type != second->type || first->count != second->count
+		|| first->fromValue != second->fromValue || first->toValue != second->toValue || first->stepValue != second->stepValue)
+		return false;
+
+	// Filters are merged only for the same compiled path
+	if (first->type == STEP_FILTER)
+		return (first->terms == second->terms);
+
+	for (i = 0; i < first->count; ++i)
+	{
+		if (first->type == STEP_CHILD)
+		{
+			if (first->names[i].strLen != second->names[i].strLen
+				|| memcmp(first->names[i].strPtr, second->names[i].strPtr, first->names[i].strLen) != 0)
+				return false;
+		}
+		else if (first->indexes[i] != second->indexes[i])
+			return false;
+	}
+
+	return true;
+}
+
+// Returns the child with the same step, a new child is added if not found
+static size_t addChild(CJPathMulti* multi, size_t parent, const CJPathStep* step)
+{
+	MultiNode* node;
+	size_t idx, last;
+
+	last = MULTI_NONE;
+	for (idx = multi->nodes[parent].firstChild; idx != MULTI_NONE; idx = multi->nodes[idx].nextSibling)
+	{
+		if (stepsEqual(multi->nodes[idx].step, step))
+			return idx;
+
+		last = idx;
+	}
+
+	idx = multi->nodeCount++;
+	node = &multi->nodes[idx];
+	memset(node, 0, sizeof(MultiNode));
+	node->step = step;
+	node->firstChild = MULTI_NONE;
+	node->nextSibling = MULTI_NONE;
+	node->firstPath = MULTI_NONE;
+	node->lastPath = MULTI_NONE;
+
+	// Children are kept in the order of the paths
+	if (last == MULTI_NONE)
+		multi->nodes[parent].firstChild = idx;
+	else
+		multi->nodes[last].nextSibling = idx;
+
+	return idx;
+}
+
+// Collects the children properties used by the evaluation
+static void prepareNode(CJPathMulti* multi, MultiNode* node)
+{
+	const MultiNode* child;
+	const CJPathStep* step;
+	size_t idx, i, limit;
+
+	node->nameBase = multi->nameCount;
+	node->arrayLimit = 0;
+
+	for (idx = node->firstChild; idx != MULTI_NONE; idx = child->nextSibling)
+	{
+		child = &multi->nodes[idx];
+		step = child->step;
+
+		switch (step->type)
+		{
+		case STEP_CHILD:
+			node->nameCount += step->count;
+			node->objectChildren = true;
+			break;
+
+		case STEP_WILDCARD:
+		case STEP_FILTER:
+			node->hasWildcard = true;
+			node->objectChildren = true;
+			node->arrayChildren = true;
+			node->arrayLimit = MULTI_NONE;
+			break;
+
+		case STEP_INDEXES:
+			node->arrayChildren = true;
+			for (i = 0; i < step->count; ++i)
+			{
+				if (node->arrayLimit != MULTI_NONE && step->indexes[i] > node->arrayLimit)
+					node->arrayLimit = step->indexes[i];
+			}
+			break;
+
+		case STEP_SLICE:
+			node->arrayChildren = true;
+			limit = (step->toValue == PTRDIFF_MAX) ? MULTI_NONE : (size_t)step->toValue - 1;
+			if (node->arrayLimit != MULTI_NONE && limit > node->arrayLimit)
+				node->arrayLimit = limit;
+			break;
+		}
+	}
+
+	multi->nameCount += node->nameCount;
+}
+
+CJPathStatus CJPathMultiCreate(const CJPathCompiled* const* compiled, size_t compiledCount, CJPathMulti** multi,
+	MemAllocFunc memAllocFunc)
+{
+	CJPathMulti* ptr;
+	size_t nodesOffset, pathNextOffset, size, maxNodes;
+	size_t i, j, node;
+
+	if (compiled == NULL || compiledCount == 0 || multi == NULL || memAllocFunc == NULL)
+		return INVALID_ARGUMENT;
+
+	*multi = NULL;
+
+	// Root node and one node per step at most
+	maxNodes = 1;
+	for (i = 0; i < compiledCount; ++i)
+	{
+		if (compiled[i] == NULL)
+			return INVALID_ARGUMENT;
+
+		// Descendants and items selected from the end are not merged into the prefix tree
+		for (j = 0; j < compiled[i]->stepCount; ++j)
+		{
+			if (compiled[i]->steps[j].recursive || compiled[i]->steps[j].fromEnd)
+				return INVALID_JSON_PATH;
+		}
+
+		maxNodes += compiled[i]->stepCount;
+	}
+
+	// Nodes and paths list are stored in one block
+	nodesOffset = sizeof(CJPathMulti);
+	pathNextOffset = nodesOffset + maxNodes * sizeof(MultiNode);
+	size = pathNextOffset + compiledCount * sizeof(size_t);
+
+	ptr = (CJPathMulti*)memAllocFunc(size);
+	if (ptr == NULL)
+		return BAD_ALLOC;
+
+	ptr->pathCount = compiledCount;
+	ptr->nodeCount = 1;
+	ptr->nameCount = 0;
+	ptr->nodes = (MultiNode*)((char*)ptr + nodesOffset);
+	ptr->pathNext = (size_t*)((char*)ptr + pathNextOffset);
+
+	memset(&ptr->nodes[0], 0, sizeof(MultiNode));
+	ptr->nodes[0].firstChild = MULTI_NONE;
+	ptr->nodes[0].nextSibling = MULTI_NONE;
+	ptr->nodes[0].firstPath = MULTI_NONE;
+	ptr->nodes[0].lastPath = MULTI_NONE;
+
+	// Build the prefix tree
+	for (i = 0; i < compiledCount; ++i)
+	{
+		node = 0;
+		for (j = 0; j < compiled[i]->stepCount; ++j)
+			node = addChild(ptr, node, &compiled[i]->steps[j]);
+
+		ptr->pathNext[i] = MULTI_NONE;
+		if (ptr->nodes[node].lastPath == MULTI_NONE)
+			ptr->nodes[node].firstPath = i;
+		else
+			ptr->pathNext[ptr->nodes[node].lastPath] = i;
+		ptr->nodes[node].lastPath = i;
+	}
+
+	for (i = 0; i < ptr->nodeCount; ++i)
+		prepareNode(ptr, &ptr->nodes[i]);
+
+	*multi = ptr;
+
+	return SUCCESS;
+}
+
+static CJPathStatus evaluateNode(MultiContext* ctx, size_t nodeIdx, const CJPathResult* value);
+
+// Members of the object are read once and passed to all matching children
+static CJPathStatus evaluateMembers(MultiContext* ctx, const MultiNode* node, const CJPathResult* value)
+{
+	CJPathStatus status;
+	CJPathResult key, res;
+	const MultiNode* child;
+	const CJPathStep* step;
+	bool* nameFound;
+	const char* ptr;
+	const char* const endOfFile = value->strPtr + value->strLen;
+	size_t idx, i, nameLeft;
+
+	nameFound = ctx->nameFound + node->nameBase;
+	memset(nameFound, 0, node->nameCount * sizeof(bool));
+	nameLeft = node->nameCount;
+
+	for (ptr = value->strPtr; ptr != endOfFile && (ptr == value->strPtr || ptr[0] == ',');)
+	{
+		// All names are found
+		if (nameLeft == 0 && !node->hasWildcard)
+			break;
+
+		status = nextMember(NULL, &ptr, endOfFile, &key, &res);
+		if (status == NOT_FOUND)
+			break;
+		if (status != SUCCESS)
+			return status;
+
+		for (idx = node->firstChild; idx != MULTI_NONE; idx = child->nextSibling)
+		{
+			child = &ctx->multi->nodes[idx];
+			step = child->step;
+
+			if (step->type == STEP_WILDCARD || (step->type == STEP_FILTER && filterMatches(NULL, step, &res)))
+			{
+				status = evaluateNode(ctx, idx, &res);
+				if (status != SUCCESS)
+					return status;
+			}
+
+			if (step->type != STEP_CHILD)
+				continue;
+
+			// Only the first member with the same name is taken
+			for (i = 0; i < step->count; ++i, ++nameFound)
+			{
+				if (*nameFound || key.strLen != step->names[i].strLen || memcmp(key.strPtr, step->names[i].strPtr, key.strLen) != 0)
+					continue;
+
+				*nameFound = true;
+				--nameLeft;
+
+				status = evaluateNode(ctx, idx, &res);
+				if (status != SUCCESS)
+					return status;
+			}
+		}
+
+		nameFound = ctx->nameFound + node->nameBase;
+	}
+
+	return SUCCESS;
+}
+
+// Items of the array are read once up to the highest required index
+static CJPathStatus evaluateItems(MultiContext* ctx, const MultiNode* node, const CJPathResult* value)
+{
+	CJPathStatus status;
+	CJPathResult res;
+	const MultiNode* child;
+	const char* ptr;
+	const char* const end = value->strPtr + value->strLen;
+	size_t idx, i;
+
+	for (ptr = value->strPtr, i = 0; node->arrayLimit == MULTI_NONE || i <= node->arrayLimit; ++i)
+	{
+		if (ptr == end || (ptr != value->strPtr && ptr[0] != ','))
+			return isArrayEnd(value->strPtr, ptr, end) ? SUCCESS : INVALID_JSON;
+
+		status = nextArrayItem(NULL, &ptr, end, &res);
+		if (status == NOT_FOUND)
+			return isArrayEnd(value->strPtr, ptr, end) ? SUCCESS : INVALID_JSON;
+		if (status != SUCCESS)
+			return status;
+
+		for (idx = node->firstChild; idx != MULTI_NONE; idx = child->nextSibling)
+		{
+			child = &ctx->multi->nodes[idx];
+			if (child->step->type == STEP_CHILD || !isIndexSelected(child->step, i)
+				|| (child->step->type == STEP_FILTER && !filterMatches(NULL, child->step, &res)))
+				continue;
+
+			status = evaluateNode(ctx, idx, &res);
+			if (status != SUCCESS)
+				return status;
+		}
+	}
+
+	return SUCCESS;
+}
+
+static CJPathStatus evaluateNode(MultiContext* ctx, size_t nodeIdx, const CJPathResult* value)
+{
+	CJPathStatus status;
+	size_t path;
+
+	const MultiNode* const node = &ctx->multi->nodes[nodeIdx];
+
+	for (path = node->firstPath; path != MULTI_NONE; path = ctx->multi->pathNext[path])
+	{
+		status = appendResultToArray(&ctx->resultArrays[path], value, ctx->allocator);
+		if (status != SUCCESS)
+			return status;
+
+		++ctx->resultCount;
+	}
+
+	if (value->strPtr[0] == '{' && node->objectChildren)
+		return evaluateMembers(ctx, node, value);
+
+	if (value->strPtr[0] == '[' && node->arrayChildren)
+		return evaluateItems(ctx, node, value);
+
+	return SUCCESS;
+}
+
+CJPathStatus CJPathMultiEvaluate(const char* jsonData, size_t jsonDataLen, const CJPathMulti* multi,
+	CJPathArray* resultArrays, MemAllocFunc memAllocFunc, MemFreeFunc memFreeFunc)
+{
+	CJPathStatus status;
+	CJPathAllocator allocator;
+	MultiContext ctx;
+	CJPathResult root;
+	size_t* counts;
+	size_t i;
+
+	if (jsonData == NULL || multi == NULL || resultArrays == NULL || memAllocFunc == NULL || memFreeFunc == NULL)
+		return INVALID_ARGUMENT;
+
+	if (jsonDataLen < 5)
+		return INVALID_JSON;
+
+	allocator.memAllocFunc = memAllocFunc;
+	allocator.memFreeFunc = memFreeFunc;
+	allocator.arena = NULL;
+
+	// Flags of the found names and the initial counts of the arrays are stored in one block
+	counts = (size_t*)memAllocFunc(multi->pathCount * sizeof(size_t) + multi->nameCount * sizeof(bool));
+	if (counts == NULL)
+		return BAD_ALLOC;
+
+	for (i = 0; i < multi->pathCount; ++i)
+		counts[i] = resultArrays[i].count;
+
+	ctx.multi = multi;
+	ctx.resultArrays = resultArrays;
+	ctx.allocator = &allocator;
+	ctx.nameFound = (bool*)(counts + multi->pathCount);
+	ctx.resultCount = 0;
+
+	// Root element
+	root.strPtr = skipSpaces(jsonData, jsonData + jsonDataLen);
+	root.strLen = (size_t)(jsonData + jsonDataLen - root.strPtr);
+
+	if (root.strLen != 0)
+		status = evaluateNode(&ctx, 0, &root);
+	else
+		status = SUCCESS;
+
+	if (status == SUCCESS && !ctx.resultCount)
+		status = NOT_FOUND;
+
+	// Drop the items of the failed evaluation, the memory is kept for reuse
+	if (status != SUCCESS)
+	{
+		for (i = 0; i < multi->pathCount; ++i)
+			resultArrays[i].count = counts[i];
+	}
+
+	memFreeFunc(counts);
+
+	return status;
+}
+
+void CJPathMultiFree(CJPathMulti** multi, MemFreeFunc memFreeFunc)
+{
+	if (multi == NULL || *multi == NULL)
+		return;
+
+	memFreeFunc(*multi);
+	*multi = NULL;
+}
\ No newline at end of file
@@ -0,0 +1,311 @@
+#include "CJPath_internal.h"
+#include "CJPath_utils.h"
+#include "CJPath_thread.h"
+#include "CJPath_stats.h"
+#include <string.h>
+
+// Parts per thread, the threads which finish early take the remaining parts
+#define PARALLEL_PARTS_PER_THREAD 8
+
+// Smaller arrays are not worth the threads
+#define PARALLEL_MIN_PART_SIZE (64 * 1024)
+
+// Items of the array evaluated by one thread
+typedef struct
+{
+	const char* start; // [ or , before the first item
+	const char* end;   // after the , following the last item or the end of the array
+	size_t firstIndex;
+
+	CJPathArray results;
+	CJPathStatus status;
+} ArrayPart;
+
+// State shared by the threads
+typedef struct
+{
+	const CJPathCompiled* compiled;
+	size_t stepIdx;
+	ArrayPart* parts;
+	size_t partCount;
+
+	// Next part to evaluate, taken under the lock
+	size_t nextPart;
+	CJPathMutex lock;
+
+	CJPathAllocator allocator;
+} ParallelJob;
+
+typedef struct
+{
+	ParallelJob* job;
+	CJPathThread thread;
+	bool started;
+
+#if defined(CJPATH_STATS)
+	CJPathStats stats;
+	CJPathStats* callerStats;
+#endif
+} ParallelWorker;
+
+// Index of the step selecting the array items, the leading steps select one member each.
+// Returns false if the path has no such step or the step selects a few items: the serial walk stops after them.
+static bool findArrayStep(const CJPathCompiled* compiled, size_t* stepIdx)
+{
+	const CJPathStep* step;
+	size_t i;
+
+	for (i = 0; i < compiled->stepCount; ++i)
+	{
+		step = &compiled->steps[i];
+		if (step->recursive)
+			return false;
+
+		if (step->type != STEP_CHILD)
+		{
+			*stepIdx = i;
+			return (step->type == STEP_WILDCARD || step->type == STEP_FILTER
+				|| (step->type == STEP_SLICE && !step->fromEnd && step->toValue == PTRDIFF_MAX));
+		}
+
+		if (step->count != 1)
+			return false;
+	}
+
+	return false;
+}
+
+// Splits the array at the commas between the items, strings and nested values are skipped.
+// If parts is NULL, only the parts are counted. Returns 0 if the array is not closed.
+static size_t splitArray(const char* jsonData, const char* end, size_t partSize, ArrayPart* parts)
+{
+	const char* ptr;
+	const char* partStart;
+	size_t count, index, depth;
+
+	for (ptr = jsonData + 1, partStart = jsonData, count = 0, index = 0, depth = 0; ptr != end; ++ptr)
+	{
+		switch (ptr[0])
+		{
+		case '"':
+			ptr = skipString(NULL, ptr, end);
+			if (ptr == NULL)
+				return 0;
+			--ptr; // the closing quote
+			break;
+
+		case '{':
+		case '[':
+			++depth;
+			break;
+
+		case '}':
+			--depth;
+			break;
+
+		case ']':
+			if (depth-- != 0)
+				break;
+
+			if (parts != NULL)
+			{
+				parts[count].start = partStart;
+				parts[count].end = ptr + 1;
+			}
+			return count + 1;
+
+		case ',':
+			if (depth != 0)
+				break;
+
+			++index;
+			if ((size_t)(ptr - partStart) < partSize)
+				break;
+
+			// The comma is kept in the part, so the number before it is terminated
+			if (parts != NULL)
+			{
+				parts[count].start = partStart;
+				parts[count].end = ptr + 1;
+				parts[count + 1].firstIndex = index;
+			}
+
+			partStart = ptr;
+			++count;
+			break;
+		}
+	}
+
+	return 0;
+}
+
+static void evaluateParts(void* arg)
+{
+	ParallelWorker* const worker = (ParallelWorker*)arg;
+	ParallelJob* const job = worker->job;
+	ArrayPart* part;
+#if defined(CJPATH_STATS)
+	CJPathStats* const threadCallerStats = threadStats;
+
+	threadStats = (worker->callerStats != NULL) ? &worker->stats : NULL;
+#endif
+
+	while (1)
+	{
+		mutexLock(&job->lock);
+		part = (job->nextPart < job->partCount) ? &job->parts[job->nextPart++] : NULL;
+		mutexUnlock(&job->lock);
+
+		if (part == NULL)
+			break;
+
+		part->status = evaluateArrayRange(job->compiled, job->stepIdx, part->start, part->end, part->firstIndex,
+			&part->results, &job->allocator);
+	}
+
+#if defined(CJPATH_STATS)
+	threadStats = threadCallerStats;
+#endif
+}
+
+// Evaluates the parts by the threads, the calling thread takes the parts too
+static void runWorkers(ParallelJob* job, ParallelWorker* workers, size_t threadCount)
+{
+	size_t i;
+
+	for (i = 0; i < threadCount; ++i)
+	{
+		memset(&workers[i], 0, sizeof(ParallelWorker));
+		workers[i].job = job;
+#if defined(CJPATH_STATS)
+		workers[i].callerStats = threadStats;
+#endif
+	}
+
+	for (i = 1; i < threadCount; ++i)
+		workers[i].started = threadStart(&workers[i].thread, &evaluateParts, &workers[i]);
+
+	evaluateParts(&workers[0]);
+
+	for (i = 0; i < threadCount; ++i)
+	{
+		if (workers[i].started)
+			threadJoin(&workers[i].thread);
+
+#if defined(CJPATH_STATS)
+		CJPathStatsMerge(workers[i].callerStats, &workers[i].stats);
+#endif
+	}
+}
+
+// Appends the results of the parts in the array order
+static CJPathStatus mergeParts(const ArrayPart* parts, size_t partCount, CJPathArray* resultArray, const CJPathAllocator* allocator)
+{
+	size_t i, j;
+
+	for (i = 0; i < partCount; ++i)
+	{
+		if (parts[i].status != SUCCESS)
+			return parts[i].status;
+	}
+
+	for (i = 0; i < partCount; ++i)
+	{
+		for (j = 0; j < parts[i].results.count; ++j)
+		{
+			if (appendResultToArray(resultArray, &parts[i].results.items[j], allocator) != SUCCESS)
+				return BAD_ALLOC;
+		}
+	}
+
+	return SUCCESS;
+}
+
+CJPathStatus CJPathEvaluateParallel(const char* jsonData, size_t jsonDataLen, const CJPathCompiled* compiled, size_t threadCount,
+	CJPathArray* resultArray, MemAllocFunc memAllocFunc, MemFreeFunc memFreeFunc)
+{
+	CJPathStatus status;
+	ParallelJob job;
+	ParallelWorker* workers;
+	CJPathResult value;
+	const char* const end = jsonData + jsonDataLen;
+	size_t stepIdx, count, partSize, i;
+
+	if (jsonData == NULL || compiled == NULL || resultArray == NULL || memAllocFunc == NULL || memFreeFunc == NULL)
+		return INVALID_ARGUMENT;
+
+	if (jsonDataLen < 5)
+		return INVALID_JSON;
+
+	if (threadCount < 2 || !findArrayStep(compiled, &stepIdx))
+		return CJPathEvaluateArray(jsonData, jsonDataLen, compiled, resultArray, memAllocFunc, memFreeFunc);
+
+	// The array selected by the leading steps
+	value.strPtr = skipSpaces(jsonData, end);
+	value.strLen = (size_t)(end - value.strPtr);
+
+	for (i = 0; i < stepIdx && value.strLen != 0; ++i)
+	{
+		status = processingPath(NULL, &compiled->steps[i].names[0], value.strPtr, value.strLen, &value);
+		if (status != SUCCESS)
+			return status;
+	}
+
+	// Objects and small arrays are evaluated by the calling thread
+	if (value.strLen < PARALLEL_MIN_PART_SIZE * 2 || value.strPtr[0] != '[')
+		return CJPathEvaluateArray(jsonData, jsonDataLen, compiled, resultArray, memAllocFunc, memFreeFunc);
+
+	partSize = value.strLen / (threadCount * PARALLEL_PARTS_PER_THREAD);
+	if (partSize < PARALLEL_MIN_PART_SIZE)
+		partSize = PARALLEL_MIN_PART_SIZE;
+
+	count = splitArray(value.strPtr, value.strPtr + value.strLen, partSize, NULL);
+	if (count < 2)
+		return CJPathEvaluateArray(jsonData, jsonDataLen, compiled, resultArray, memAllocFunc, memFreeFunc);
+
+	memset(&job, 0, sizeof(job));
+	job.compiled = compiled;
+	job.stepIdx = stepIdx;
+	job.partCount = count;
+	job.allocator.memAllocFunc = memAllocFunc;
+	job.allocator.memFreeFunc = memFreeFunc;
+	job.allocator.arena = NULL;
+
+	if (threadCount > count)
+		threadCount = count;
+
+	job.parts = (ArrayPart*)memAllocFunc(count * sizeof(ArrayPart));
+	workers = (ParallelWorker*)memAllocFunc(threadCount * sizeof(ParallelWorker));
+	if (job.parts == NULL || workers == NULL)
+	{
+		if (job.parts != NULL)
+			memFreeFunc(job.parts);
+		if (workers != NULL)
+			memFreeFunc(workers);
+		return BAD_ALLOC;
+	}
+
+	memset(job.parts, 0, count * sizeof(ArrayPart));
+	splitArray(value.strPtr, value.strPtr + value.strLen, partSize, job.parts);
+
+	mutexInit(&job.lock);
+	runWorkers(&job, workers, threadCount);
+	mutexDestroy(&job.lock);
+
+	count = resultArray->count;
+	status = mergeParts(job.parts, job.partCount, resultArray, &job.allocator);
+
+	// Drop the items of the failed evaluation, the memory is kept for reuse
+	if (status != SUCCESS)
+		resultArray->count = count;
+	else if (resultArray->count == count)
+		status = NOT_FOUND;
+
+	for (i = 0; i < job.partCount; ++i)
+		CJPathFreeArray(&job.parts[i].results, memFreeFunc);
+
+	memFreeFunc(job.parts);
+	memFreeFunc(workers);
+
+	return status;
+}
@@ -0,0 +1,307 @@
+#include "CJPath_internal.h"
+#include "CJPath_structural.h"
+#include "CJPath_stats.h"
+#include <string.h>
+
+bool charIsIntegerNum(const char value)
+{
+	return (value >= '0' && value <= '9');
+}
+
+bool charIsSpace(const char value)
+{
+	return (value == ' ' || value == '\t' || value == '\n' || value == '\r');
+}
+
+const char* skipSpaces(const char* ptr, const char* end)
+{
+	while (ptr != end && charIsSpace(ptr[0]))
+		++ptr;
+
+	return ptr;
+}
+
+// Compares the literal (true, false, null) without reading beyond the end
+bool isLiteral(const char* ptr, const char* end, const char* literal, size_t literalLen)
+{
+	return ((size_t)(end - ptr) >= literalLen && memcmp(ptr, literal, literalLen) == 0);
+}
+
+// Skips the string, returns pointer after the closing quote or NULL
+const char* skipString(const CJPathStructuralIndex* structural, const char* ptr, const char* end)
+{
+	const char* ptrEnd;
+	bool found;
+
+	if (structural != NULL)
+	{
+		ptrEnd = structuralSkipString(structural, ptr, end, &found);
+		if (found)
+			return ptrEnd;
+	}
+
+	for (++ptr; ptr < end; ++ptr)
+	{
+		if (ptr[0] == '\\')
+			++ptr; // Skip escaped symbol
+		else if (ptr[0] == '"')
+			return ptr + 1;
+	}
+
+	return NULL;
+}
+
+// Skips the object or array, returns pointer after the closing bracket or NULL.
+// Strings are skipped, so brackets inside them are not counted.
+const char* skipContainer(const CJPathStructuralIndex* structural, const char* ptr, const char* end)
+{
+	const char* ptrEnd;
+	size_t depth;
+	bool found;
+
+	if (structural != NULL)
+	{
+		ptrEnd = structuralSkipContainer(structural, ptr, end, &found);
+		if (found)
+			return ptrEnd;
+	}
+
+	for (depth = 0; ptr < end; ++ptr)
+	{
+		switch (ptr[0])
+		{
+		case '"':
+			ptr = skipString(NULL, ptr, end);
+			if (ptr == NULL)
+				return NULL;
+			--ptr;
+			break;
+
+		case '{':
+		case '[':
+			++depth;
+			break;
+
+		case '}':
+		case ']':
+			if (--depth == 0)
+				return ptr + 1;
+			break;
+		}
+	}
+
+	return NULL;
+}
+
+bool charIsNumberStart(const char value)
+{
+	return (charIsIntegerNum(value) || value == '-');
+}
+
+bool charIsNumberPart(const char value)
+{
+	return (charIsIntegerNum(value) || value == '.' || value == 'e' || value == 'E' || value == '+' || value == '-');
+}
+
+bool isValueStart(const char* ptr, const char* end)
+{
+	return (ptr[0] == '"' || ptr[0] == '{' || ptr[0] == '[' || charIsNumberStart(ptr[0])
+		|| isLiteral(ptr, end, JSON_VALUE_TRUE, JSON_VALUE_TRUE_LEN)
+		|| isLiteral(ptr, end, JSON_VALUE_FALSE, JSON_VALUE_FALSE_LEN)
+		|| isLiteral(ptr, end, JSON_VALUE_NULL, JSON_VALUE_NULL_LEN));
+}
+
+// Extracts the value starting at ptr
+CJPathStatus extractValue(const CJPathStructuralIndex* structural, const char* ptr, const char* end, CJPathResult* result)
+{
+	const char* ptrEnd;
+
+	result->strPtr = ptr;
+
+	// Find end of string
+	if (ptr[0] == '"')
+	{
+		ptrEnd = skipString(structural, ptr, end);
+		if (ptrEnd == NULL)
+			return INVALID_JSON;
+	}
+
+	// Find end of object or array
+	else if (ptr[0] == '{' || ptr[0] == '[')
+	{
+		ptrEnd = skipContainer(structural, ptr, end);
+		if (ptrEnd == NULL)
+			return INVALID_JSON;
+	}
+
+	// Find end of number
+	else if (charIsNumberStart(ptr[0]))
+	{
+		for (ptrEnd = ptr + 1; ptrEnd != end && charIsNumberPart(ptrEnd[0]); ++ptrEnd);
+
+		// The number must be terminated
+		if (ptrEnd == end)
+			return INVALID_JSON;
+	}
+
+	else if (isLiteral(ptr, end, JSON_VALUE_TRUE, JSON_VALUE_TRUE_LEN))
+		ptrEnd = ptr + JSON_VALUE_TRUE_LEN;
+
+	else if (isLiteral(ptr, end, JSON_VALUE_FALSE, JSON_VALUE_FALSE_LEN))
+		ptrEnd = ptr + JSON_VALUE_FALSE_LEN;
+
+	else if (isLiteral(ptr, end, JSON_VALUE_NULL, JSON_VALUE_NULL_LEN))
+		ptrEnd = ptr + JSON_VALUE_NULL_LEN;
+
+	else
+		return INVALID_JSON;
+
+	result->strLen = (size_t)(ptrEnd - ptr);
+
+	return SUCCESS;
+}
+
+// Reads the next member ("key": value) of the object.
+// ptr points to { or , before the member and is moved to the symbol after the value.
+CJPathStatus nextMember(const CJPathStructuralIndex* structural, const char** ptr, const char* end, CJPathResult* key, CJPathResult* value)
+{
+	CJPathStatus status;
+	const char* cur;
+	const char* keyEnd;
+
+	cur = skipSpaces(*ptr + 1, end);
+	if (cur == end || cur[0] != '"') // End of object
+		return NOT_FOUND;
+
+	keyEnd = skipString(structural, cur, end);
+	if (keyEnd == NULL)
+		return INVALID_JSON;
+
+	key->strPtr = cur + 1;
+	key->strLen = (size_t)(keyEnd - cur) - 2;
+
+	cur = skipSpaces(keyEnd, end);
+	if (cur == end || cur[0] != ':')
+		return INVALID_JSON;
+
+	cur = skipSpaces(cur + 1, end);
+	if (cur == end)
+		return INVALID_JSON;
+
+	status = extractValue(structural, cur, end, value);
+	if (status != SUCCESS)
+		return status;
+
+	STATS_ADD(bytesScanned, skipSpaces(value->strPtr + value->strLen, end) - *ptr);
+	*ptr = skipSpaces(value->strPtr + value->strLen, end);
+
+	return SUCCESS;
+}
+
+// Reads the next item of the array.
+// ptr points to [ or , before the item and is moved to the symbol after the value.
+CJPathStatus nextArrayItem(const CJPathStructuralIndex* structural, const char** ptr, const char* end, CJPathResult* value)
+{
+	CJPathStatus status;
+	const char* cur;
+
+	cur = skipSpaces(*ptr + 1, end);
+	if (cur == end || cur[0] == ']') // End of array
+		return NOT_FOUND;
+
+	status = extractValue(structural, cur, end, value);
+	if (status != SUCCESS)
+		return status;
+
+	STATS_ADD(bytesScanned, skipSpaces(value->strPtr + value->strLen, end) - *ptr);
+	*ptr = skipSpaces(value->strPtr + value->strLen, end);
+
+	return SUCCESS;
+}
+
+// The walk of the items stopped at the closing bracket, not at a missing comma or after a trailing one.
+// The bracket pairs are not checked by skipContainer, so the array may be closed by either bracket.
+bool isArrayEnd(const char* start, const char* ptr, const char* end)
+{
+	return (ptr == start || (ptr != end && (ptr[0] == ']' || ptr[0] == '}')));
+}
+
+// Binary search in the sorted indexes
+static bool containsIndex(const size_t* indexes, size_t count, size_t index)
+{
+	size_t first, last, middle;
+
+	for (first = 0, last = count; first < last; )
+	{
+		middle = first + (last - first) / 2;
+		if (indexes[middle] < index)
+			first = middle + 1;
+		else
+			last = middle;
+	}
+
+	return (first < count && indexes[first] == index);
+}
+
+bool isIndexSelected(const CJPathStep* step, size_t index)
+{
+	switch (step->type)
+	{
+	case STEP_INDEXES:
+		return containsIndex(step->indexes, step->count, index);
+
+	case STEP_SLICE:
+		return ((ptrdiff_t)index >= step->fromValue && (ptrdiff_t)index < step->toValue
+			&& ((ptrdiff_t)index - step->fromValue) % step->stepValue == 0);
+
+	default:
+		return true;
+	}
+}
+
+static ptrdiff_t clampBound(ptrdiff_t value, ptrdiff_t min, ptrdiff_t max)
+{
+	return (value < min) ? min : (value > max) ? max : value;
+}
+
+// The items from first are selected by the step while they are before last (after last for the negative step)
+void resolveSlice(const CJPathStep* step, size_t length, ptrdiff_t* first, ptrdiff_t* last)
+{
+	const ptrdiff_t len = (ptrdiff_t)length;
+	ptrdiff_t from, to;
+
+	from = (step->fromValue < 0) ? step->fromValue + len : step->fromValue;
+	to = (step->toValue < 0) ? step->toValue + len : step->toValue;
+
+	if (step->stepValue > 0)
+	{
+		*first = clampBound(from, 0, len);
+		*last = clampBound(to, 0, len);
+	}
+	else
+	{
+		*first = clampBound(from, -1, len - 1);
+		*last = clampBound(to, -1, len - 1);
+	}
+}
+
+bool isTailIndexSelected(const CJPathStep* step, size_t index, size_t length)
+{
+	ptrdiff_t first, last;
+
+	switch (step->type)
+	{
+	case STEP_INDEXES:
+		return (containsIndex(step->indexes, step->count, index)
+			|| containsIndex(step->tailIndexes, step->tailCount, length - index));
+
+	case STEP_SLICE:
+		resolveSlice(step, length, &first, &last);
+		if (step->stepValue > 0)
+			return ((ptrdiff_t)index >= first && (ptrdiff_t)index < last && ((ptrdiff_t)index - first) % step->stepValue == 0);
+		return ((ptrdiff_t)index <= first && (ptrdiff_t)index > last && (first - (ptrdiff_t)index) % step->stepValue == 0);
+
+	default:
+		return true;
+	}
+}
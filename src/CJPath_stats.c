@@ -0,0 +1,60 @@
+#if defined(CJPATH_STATS) && !defined(_WIN32)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "CJPath_stats.h"
+
+#if defined(CJPATH_STATS)
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+CJPATH_THREAD_LOCAL CJPathStats* threadStats;
+
+uint64_t statsNow(void)
+{
+#if defined(_WIN32)
+	LARGE_INTEGER frequency, counter;
+
+	QueryPerformanceFrequency(&frequency);
+	QueryPerformanceCounter(&counter);
+	return (uint64_t)((double)counter.QuadPart * 1e9 / (double)frequency.QuadPart);
+#else
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+#endif
+
+void CJPathStatsAttach(CJPathStats* stats)
+{
+#if defined(CJPATH_STATS)
+	threadStats = stats;
+#else
+	(void)stats;
+#endif
+}
+
+void CJPathStatsMerge(CJPathStats* total, const CJPathStats* stats)
+{
+	if (total == NULL || stats == NULL)
+		return;
+
+	total->evaluations += stats->evaluations;
+	total->bytesScanned += stats->bytesScanned;
+	total->pathLookups += stats->pathLookups;
+	total->charSearches += stats->charSearches;
+	total->allocations += stats->allocations;
+	total->allocatedBytes += stats->allocatedBytes;
+
+	if (total->maxDepth < stats->maxDepth)
+		total->maxDepth = stats->maxDepth;
+
+	total->evaluationTimeNs += stats->evaluationTimeNs;
+}
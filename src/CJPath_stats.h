@@ -0,0 +1,42 @@
+#ifndef _CJPATH_STATS_H
+#define _CJPATH_STATS_H
+
+#include "CJPath.h"
+
+// Statistics of the evaluation, the counters are compiled only with CJPATH_STATS
+#if defined(CJPATH_STATS)
+
+#if defined(_MSC_VER)
+#define CJPATH_THREAD_LOCAL __declspec(thread)
+#elif defined(CJPATH_NO_THREADS)
+#define CJPATH_THREAD_LOCAL
+#else
+#define CJPATH_THREAD_LOCAL __thread
+#endif
+
+// Statistics attached by the calling thread
+extern CJPATH_THREAD_LOCAL CJPathStats* threadStats;
+
+uint64_t statsNow(void);
+
+#define STATS_ADD(field, value) do { if (threadStats != NULL) threadStats->field += (uint64_t)(value); } while (0)
+#define STATS_MAX(field, value) do { if (threadStats != NULL && threadStats->field < (uint64_t)(value)) \
+	threadStats->field = (uint64_t)(value); } while (0)
+
+// The statement is counted as one evaluation and timed as a whole, the clock is read twice per query
+#define STATS_EVALUATION(statement) do { const uint64_t statsStart = (threadStats != NULL) ? statsNow() : 0; \
+	statement; \
+	if (threadStats != NULL) { \
+		threadStats->evaluations += 1; \
+		threadStats->evaluationTimeNs += statsNow() - statsStart; \
+	} } while (0)
+
+#else
+
+#define STATS_ADD(field, value) ((void)0)
+#define STATS_MAX(field, value) ((void)0)
+#define STATS_EVALUATION(statement) do { statement; } while (0)
+
+#endif
+
+#endif // _CJPATH_STATS_H
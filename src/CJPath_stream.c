@@ -0,0 +1,568 @@
+#include "CJPath_internal.h"
+#include <string.h>
+
+// Parser state between the chunks
+typedef enum
+{
+	STREAM_VALUE,          // Expecting a value
+	STREAM_MEMBER_OR_END,  // After { or , in the object
+	STREAM_KEY,            // Inside the member name
+	STREAM_COLON,          // After the member name
+	STREAM_ITEM_OR_END,    // After [ or , in the array
+	STREAM_NEXT_OR_END,    // After the member or item value
+	STREAM_SKIP_STRING,    // Inside the string value
+	STREAM_SKIP_CONTAINER, // Inside the object or array which is not on the path
+	STREAM_SKIP_SCALAR,    // Inside the number or literal
+	STREAM_DONE            // After the root value
+} StreamState;
+
+// What is done with the next value
+typedef enum
+{
+	ROLE_SKIP,    // Not selected by the path
+	ROLE_DESCEND, // Selected by the leading steps, the children are checked by the next step
+	ROLE_MATCH    // Selected by all steps
+} StreamRole;
+
+// Object or array selected by the leading steps, the children are checked by the step with the same index
+typedef struct
+{
+	bool object;
+	size_t index;
+} StreamLevel;
+
+struct _CJPathStream
+{
+	const CJPathCompiled* compiled;
+	CJPathResultCallback callback;
+	void* userData;
+
+	CJPathStatus status;
+	StreamState state;
+	StreamRole role;
+	size_t resultCount;
+
+	// Levels on the path, stepCount at most
+	StreamLevel* levels;
+	size_t depth;
+
+	// Flags of the found names, nameBase[i] is the first flag of the step i
+	size_t* nameBase;
+	bool* nameFound;
+
+	// Member name, only names not longer than the longest step name are stored
+	char* key;
+	size_t keyCapacity;
+	size_t keyLen;
+
+	// Nesting of the skipped value, the rest of the top level is skipped if skipLevel is set
+	size_t skipDepth;
+	bool skipString;
+	bool skipLevel;
+	bool escape;
+
+	// Part of the matched value received in the previous chunks
+	char* value;
+	size_t valueCapacity;
+	size_t valueLen;
+	bool capturing;
+	const char* captureStart;
+};
+
+static CJPathStatus appendValue(CJPathStream* stream, const char* ptr, size_t len)
+{
+	if (len > stream->valueCapacity - stream->valueLen)
+		return BUFFER_TOO_SMALL;
+
+	memcpy(stream->value + stream->valueLen, ptr, len);
+	stream->valueLen += len;
+
+	return SUCCESS;
+}
+
+// Checks the member or item of the top level against its step
+static void selectChild(CJPathStream* stream)
+{
+	const StreamLevel* const level = &stream->levels[stream->depth - 1];
+	const CJPathStep* const step = &stream->compiled->steps[stream->depth - 1];
+	bool* nameFound;
+	bool selected;
+	size_t i;
+
+	selected = false;
+
+	if (step->type == STEP_WILDCARD)
+		selected = true;
+	else if (level->object && step->type == STEP_CHILD)
+	{
+		// Only the first member with the same name is taken
+		nameFound = stream->nameFound + stream->nameBase[stream->depth - 1];
+		for (i = 0; i < step->count && !selected; ++i)
+		{
+			if (!nameFound[i] && stream->keyLen == step->names[i].strLen
+				&& memcmp(stream->key, step->names[i].strPtr, stream->keyLen) == 0)
+			{
+				nameFound[i] = true;
+				selected = true;
+			}
+		}
+	}
+	else if (!level->object && step->type != STEP_CHILD)
+		selected = isIndexSelected(step, level->index);
+
+	if (!selected)
+		stream->role = ROLE_SKIP;
+	else if (stream->depth == stream->compiled->stepCount)
+		stream->role = ROLE_MATCH;
+	else
+		stream->role = ROLE_DESCEND;
+}
+
+// The remaining members or items of the top level cannot be selected by its step
+static bool levelExhausted(const CJPathStream* stream)
+{
+	const StreamLevel* const level = &stream->levels[stream->depth - 1];
+	const CJPathStep* const step = &stream->compiled->steps[stream->depth - 1];
+	const bool* nameFound;
+	size_t i;
+
+	switch (step->type)
+	{
+	case STEP_CHILD:
+		if (!level->object)
+			return true;
+
+		nameFound = stream->nameFound + stream->nameBase[stream->depth - 1];
+		for (i = 0; i < step->count; ++i)
+		{
+			if (!nameFound[i])
+				return false;
+		}
+		return true;
+
+	case STEP_INDEXES:
+		return (level->object || level->index > step->indexes[step->count - 1]);
+
+	case STEP_SLICE:
+		return (level->object || (ptrdiff_t)level->index >= step->toValue);
+
+	default:
+		return false;
+	}
+}
+
+// Skips the rest of the top level up to its closing bracket
+static void skipLevel(CJPathStream* stream)
+{
+	stream->skipDepth = 1;
+	stream->skipString = false;
+	stream->skipLevel = true;
+	stream->escape = false;
+	stream->state = STREAM_SKIP_CONTAINER;
+}
+
+// The member or item value is read, ptr points after the value
+static CJPathStatus endValue(CJPathStream* stream, const char* ptr)
+{
+	CJPathStatus status;
+	CJPathResult result;
+
+	if (stream->capturing)
+	{
+		stream->capturing = false;
+
+		// The value within one chunk is passed without copying
+		if (stream->valueLen == 0)
+		{
+			result.strPtr = stream->captureStart;
+			result.strLen = (size_t)(ptr - stream->captureStart);
+		}
+		else
+		{
+			status = appendValue(stream, stream->captureStart, (size_t)(ptr - stream->captureStart));
+			if (status != SUCCESS)
+				return status;
+
+			result.strPtr = stream->value;
+			result.strLen = stream->valueLen;
+			stream->valueLen = 0;
+		}
+
+		++stream->resultCount;
+
+		status = stream->callback(&result, stream->userData);
+		if (status != SUCCESS)
+			return status;
+	}
+
+	stream->state = (stream->depth != 0) ? STREAM_NEXT_OR_END : STREAM_DONE;
+
+	return SUCCESS;
+}
+
+// Starts reading the value, ptr points to its first symbol
+static CJPathStatus beginValue(CJPathStream* stream, const char* ptr)
+{
+	StreamLevel* level;
+
+	if (stream->role == ROLE_MATCH)
+	{
+		stream->capturing = true;
+		stream->captureStart = ptr;
+	}
+
+	if (ptr[0] == '{' || ptr[0] == '[')
+	{
+		if (stream->role == ROLE_DESCEND)
+		{
+			level = &stream->levels[stream->depth];
+			level->object = (ptr[0] == '{');
+			level->index = 0;
+
+			memset(stream->nameFound + stream->nameBase[stream->depth], 0,
+				stream->compiled->steps[stream->depth].count * sizeof(bool));
+
+			++stream->depth;
+			stream->state = level->object ? STREAM_MEMBER_OR_END : STREAM_ITEM_OR_END;
+
+			if (levelExhausted(stream))
+				skipLevel(stream);
+		}
+		else
+		{
+			stream->skipDepth = 1;
+			stream->skipString = false;
+			stream->skipLevel = false;
+			stream->escape = false;
+			stream->state = STREAM_SKIP_CONTAINER;
+		}
+	}
+	else if (ptr[0] == '"')
+	{
+		stream->escape = false;
+		stream->state = STREAM_SKIP_STRING;
+	}
+	else if (charIsNumberStart(ptr[0]) || ptr[0] == 't' || ptr[0] == 'f' || ptr[0] == 'n')
+		stream->state = STREAM_SKIP_SCALAR;
+	else
+		return INVALID_JSON;
+
+	return SUCCESS;
+}
+
+// Closes the top level by } or ]
+static CJPathStatus endLevel(CJPathStream* stream, char symbol)
+{
+	if (stream->levels[stream->depth - 1].object != (symbol == '}'))
+		return INVALID_JSON;
+
+	--stream->depth;
+	stream->state = (stream->depth != 0) ? STREAM_NEXT_OR_END : STREAM_DONE;
+
+	return SUCCESS;
+}
+
+// Processes the symbols of the chunk until the end or an error
+static void feedSymbols(CJPathStream* stream, const char* ptr, const char* end)
+{
+	CJPathStatus status;
+	StreamLevel* level;
+
+	for (status = SUCCESS; ptr != end && status == SUCCESS; )
+	{
+		switch (stream->state)
+		{
+		case STREAM_VALUE:
+			if (!charIsSpace(ptr[0]))
+				status = beginValue(stream, ptr);
+			++ptr;
+			break;
+
+		case STREAM_MEMBER_OR_END:
+			if (ptr[0] == '"')
+			{
+				stream->keyLen = 0;
+				stream->escape = false;
+				stream->state = STREAM_KEY;
+			}
+			else if (ptr[0] == '}')
+				status = endLevel(stream, ptr[0]);
+			else if (!charIsSpace(ptr[0]))
+				status = INVALID_JSON;
+			++ptr;
+			break;
+
+		case STREAM_KEY:
+			for (; ptr != end; ++ptr)
+			{
+				if (stream->escape)
+					stream->escape = false;
+				else if (ptr[0] == '\\')
+					stream->escape = true;
+				else if (ptr[0] == '"')
+					break;
+
+				// Longer names are only counted, they do not match any step
+				if (stream->keyLen < stream->keyCapacity)
+					stream->key[stream->keyLen] = ptr[0];
+				++stream->keyLen;
+			}
+
+			if (ptr != end)
+			{
+				stream->state = STREAM_COLON;
+				++ptr;
+			}
+			break;
+
+		case STREAM_COLON:
+			if (ptr[0] == ':')
+			{
+				selectChild(stream);
+				stream->state = STREAM_VALUE;
+			}
+			else if (!charIsSpace(ptr[0]))
+				status = INVALID_JSON;
+			++ptr;
+			break;
+
+		case STREAM_ITEM_OR_END:
+			if (ptr[0] == ']')
+			{
+				status = endLevel(stream, ptr[0]);
+				++ptr;
+			}
+			else if (charIsSpace(ptr[0]))
+				++ptr;
+			else
+			{
+				// The symbol is processed again as the start of the value
+				selectChild(stream);
+				stream->state = STREAM_VALUE;
+			}
+			break;
+
+		case STREAM_NEXT_OR_END:
+			level = &stream->levels[stream->depth - 1];
+			if (ptr[0] == ',')
+			{
+				++level->index;
+				stream->state = level->object ? STREAM_MEMBER_OR_END : STREAM_ITEM_OR_END;
+
+				// Nothing more can be selected
+				if (levelExhausted(stream))
+					skipLevel(stream);
+			}
+			else if (ptr[0] == '}' || ptr[0] == ']')
+				status = endLevel(stream, ptr[0]);
+			else if (!charIsSpace(ptr[0]))
+				status = INVALID_JSON;
+			++ptr;
+			break;
+
+		case STREAM_SKIP_STRING:
+			for (; ptr != end; ++ptr)
+			{
+				if (stream->escape)
+					stream->escape = false;
+				else if (ptr[0] == '\\')
+					stream->escape = true;
+				else if (ptr[0] == '"')
+					break;
+			}
+
+			if (ptr != end)
+			{
+				++ptr;
+				status = endValue(stream, ptr);
+			}
+			break;
+
+		case STREAM_SKIP_CONTAINER:
+			for (; ptr != end; ++ptr)
+			{
+				if (stream->skipString)
+				{
+					if (stream->escape)
+						stream->escape = false;
+					else if (ptr[0] == '\\')
+						stream->escape = true;
+					else if (ptr[0] == '"')
+						stream->skipString = false;
+				}
+				else if (ptr[0] == '"')
+					stream->skipString = true;
+				else if (ptr[0] == '{' || ptr[0] == '[')
+					++stream->skipDepth;
+				else if ((ptr[0] == '}' || ptr[0] == ']') && --stream->skipDepth == 0)
+					break;
+			}
+
+			if (ptr == end)
+				break;
+
+			++ptr;
+
+			if (stream->skipLevel)
+			{
+				stream->skipLevel = false;
+				--stream->depth;
+				stream->state = (stream->depth != 0) ? STREAM_NEXT_OR_END : STREAM_DONE;
+			}
+			else
+				status = endValue(stream, ptr);
+			break;
+
+		case STREAM_SKIP_SCALAR:
+			for (; ptr != end && (charIsNumberPart(ptr[0]) || (ptr[0] >= 'a' && ptr[0] <= 'z')); ++ptr);
+
+			// The terminating symbol is processed by the next state
+			if (ptr != end)
+				status = endValue(stream, ptr);
+			break;
+
+		case STREAM_DONE:
+			if (!charIsSpace(ptr[0]))
+				status = INVALID_JSON;
+			++ptr;
+			break;
+		}
+	}
+
+	stream->status = status;
+}
+
+CJPathStatus CJPathStreamCreate(const CJPathCompiled* compiled, size_t maxValueLen, CJPathResultCallback callback,
+	void* userData, CJPathStream** stream, MemAllocFunc memAllocFunc)
+{
+	CJPathStream* ptr;
+	size_t levelsOffset, nameBaseOffset, nameFoundOffset, keyOffset, valueOffset, size;
+	size_t nameCount, keyCapacity, i, j;
+
+	if (compiled == NULL || callback == NULL || stream == NULL || memAllocFunc == NULL)
+		return INVALID_ARGUMENT;
+
+	*stream = NULL;
+
+	nameCount = 0;
+	keyCapacity = 0;
+	for (i = 0; i < compiled->stepCount; ++i)
+	{
+		// Only the values on the path are tracked, descendants cannot be found, filters would need the whole item
+		// and the items selected from the end would need the array length
+		if (compiled->steps[i].recursive || compiled->steps[i].type == STEP_FILTER || compiled->steps[i].fromEnd)
+			return INVALID_JSON_PATH;
+
+		if (compiled->steps[i].type != STEP_CHILD)
+			continue;
+
+		nameCount += compiled->steps[i].count;
+		for (j = 0; j < compiled->steps[i].count; ++j)
+		{
+			if (compiled->steps[i].names[j].strLen > keyCapacity)
+				keyCapacity = compiled->steps[i].names[j].strLen;
+		}
+	}
+
+	// Levels, flags and buffers are stored in one block, the size does not depend on the document
+	levelsOffset = sizeof(CJPathStream);
+	nameBaseOffset = levelsOffset + compiled->stepCount * sizeof(StreamLevel);
+	nameFoundOffset = nameBaseOffset + compiled->stepCount * sizeof(size_t);
+	keyOffset = nameFoundOffset + nameCount * sizeof(bool);
+	valueOffset = keyOffset + keyCapacity;
+	size = valueOffset + maxValueLen;
+
+	ptr = (CJPathStream*)memAllocFunc(size);
+	if (ptr == NULL)
+		return BAD_ALLOC;
+
+	memset(ptr, 0, sizeof(CJPathStream));
+	ptr->compiled = compiled;
+	ptr->callback = callback;
+	ptr->userData = userData;
+	ptr->levels = (StreamLevel*)((char*)ptr + levelsOffset);
+	ptr->nameBase = (size_t*)((char*)ptr + nameBaseOffset);
+	ptr->nameFound = (bool*)((char*)ptr + nameFoundOffset);
+	ptr->key = (char*)ptr + keyOffset;
+	ptr->keyCapacity = keyCapacity;
+	ptr->value = (char*)ptr + valueOffset;
+	ptr->valueCapacity = maxValueLen;
+
+	for (i = 0, nameCount = 0; i < compiled->stepCount; ++i)
+	{
+		ptr->nameBase[i] = nameCount;
+		if (compiled->steps[i].type == STEP_CHILD)
+			nameCount += compiled->steps[i].count;
+	}
+
+	CJPathStreamReset(ptr);
+
+	*stream = ptr;
+
+	return SUCCESS;
+}
+
+CJPathStatus CJPathStreamFeed(CJPathStream* stream, const char* chunk, size_t chunkLen)
+{
+	const char* const end = chunk + chunkLen;
+
+	if (stream == NULL || (chunk == NULL && chunkLen != 0))
+		return INVALID_ARGUMENT;
+
+	if (stream->status != SUCCESS)
+		return stream->status;
+
+	stream->captureStart = chunk;
+
+	feedSymbols(stream, chunk, end);
+
+	// The matched value continues in the next chunk
+	if (stream->status == SUCCESS && stream->capturing)
+		stream->status = appendValue(stream, stream->captureStart, (size_t)(end - stream->captureStart));
+
+	return stream->status;
+}
+
+CJPathStatus CJPathStreamFinish(CJPathStream* stream)
+{
+	if (stream == NULL)
+		return INVALID_ARGUMENT;
+
+	if (stream->status != SUCCESS)
+		return stream->status;
+
+	// The root number or literal is terminated by the end of the document
+	if (stream->state == STREAM_SKIP_SCALAR && stream->depth == 0)
+		stream->state = STREAM_DONE;
+
+	if (stream->state != STREAM_DONE)
+		stream->status = INVALID_JSON;
+	else if (!stream->resultCount)
+		stream->status = NOT_FOUND;
+
+	return stream->status;
+}
+
+void CJPathStreamReset(CJPathStream* stream)
+{
+	if (stream == NULL)
+		return;
+
+	stream->status = SUCCESS;
+	stream->state = STREAM_VALUE;
+	stream->role = ROLE_DESCEND;
+	stream->resultCount = 0;
+	stream->depth = 0;
+	stream->skipLevel = false;
+	stream->valueLen = 0;
+	stream->capturing = false;
+}
+
+void CJPathStreamFree(CJPathStream** stream, MemFreeFunc memFreeFunc)
+{
+	if (stream == NULL || *stream == NULL)
+		return;
+
+	memFreeFunc(*stream);
+	*stream = NULL;
+}
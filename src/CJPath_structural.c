@@ -0,0 +1,437 @@
+#include "CJPath_structural.h"
+#include "CJPath_utils.h"
+#include <string.h>
+
+#ifdef CJPATH_SSE2
+#include <emmintrin.h>
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(CJPATH_SSE2) && !defined(CJPATH_NO_AVX2)
+#define STRUCTURAL_AVX2
+#if defined(__GNUC__) || defined(__clang__)
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define TARGET_AVX2
+#endif
+#endif
+
+#define BLOCK_SIZE 64
+
+// Bit masks of one 64-byte block
+typedef struct
+{
+	uint64_t quote;
+	uint64_t backslash;
+	uint64_t structural;
+} BlockMasks;
+
+typedef void (*ClassifyFunc)(const char* block, BlockMasks* masks);
+
+#ifndef CJPATH_SSE2
+static void classifyScalar(const char* block, BlockMasks* masks)
+{
+	unsigned i;
+	uint64_t bit;
+
+	memset(masks, 0, sizeof(*masks));
+
+	for (i = 0, bit = 1; i < BLOCK_SIZE; ++i, bit <<= 1)
+	{
+		switch (block[i])
+		{
+		case '"':
+			masks->quote |= bit;
+			break;
+
+		case '\\':
+			masks->backslash |= bit;
+			break;
+
+		case '{':
+		case '}':
+		case '[':
+		case ']':
+		case ':':
+		case ',':
+			masks->structural |= bit;
+			break;
+		}
+	}
+}
+#endif
+
+#ifdef CJPATH_SSE2
+static void classifySse2(const char* block, BlockMasks* masks)
+{
+	unsigned i;
+	__m128i chunk, structural;
+
+	memset(masks, 0, sizeof(*masks));
+
+	for (i = 0; i < BLOCK_SIZE; i += 16)
+	{
+		chunk = _mm_loadu_si128((const __m128i*)(block + i));
+
+		masks->quote |= (uint64_t)(uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('"'))) << i;
+		masks->backslash |= (uint64_t)(uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('\\'))) << i;
+
+		// { and [ differ from } and ] by one bit
+		structural = _mm_or_si128(_mm_cmpeq_epi8(_mm_or_si128(chunk, _mm_set1_epi8(0x20)), _mm_set1_epi8('{')),
+			_mm_cmpeq_epi8(_mm_or_si128(chunk, _mm_set1_epi8(0x20)), _mm_set1_epi8('}')));
+		structural = _mm_or_si128(structural, _mm_cmpeq_epi8(chunk, _mm_set1_epi8(':')));
+		structural = _mm_or_si128(structural, _mm_cmpeq_epi8(chunk, _mm_set1_epi8(',')));
+
+		masks->structural |= (uint64_t)(uint32_t)_mm_movemask_epi8(structural) << i;
+	}
+}
+#endif
+
+#ifdef STRUCTURAL_AVX2
+TARGET_AVX2 static void classifyAvx2(const char* block, BlockMasks* masks)
+{
+	unsigned i;
+	__m256i chunk, lower, structural;
+
+	memset(masks, 0, sizeof(*masks));
+
+	for (i = 0; i < BLOCK_SIZE; i += 32)
+	{
+		chunk = _mm256_loadu_si256((const __m256i*)(block + i));
+
+		masks->quote |= (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('"'))) << i;
+		masks->backslash |= (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\\'))) << i;
+
+		// { and [ differ from } and ] by one bit
+		lower = _mm256_or_si256(chunk, _mm256_set1_epi8(0x20));
+		structural = _mm256_or_si256(_mm256_cmpeq_epi8(lower, _mm256_set1_epi8('{')),
+			_mm256_cmpeq_epi8(lower, _mm256_set1_epi8('}')));
+		structural = _mm256_or_si256(structural, _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8(':')));
+		structural = _mm256_or_si256(structural, _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8(',')));
+
+		masks->structural |= (uint64_t)(uint32_t)_mm256_movemask_epi8(structural) << i;
+	}
+}
+
+static bool cpuHasAvx2(void)
+{
+#if defined(__GNUC__) || defined(__clang__)
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx2") != 0;
+#elif defined(_MSC_VER)
+	int info[4];
+
+	__cpuid(info, 0);
+	if (info[0] < 7)
+		return false;
+
+	// OSXSAVE and AVX, then YMM state enabled by OS
+	__cpuid(info, 1);
+	if ((info[2] & (1 << 27)) == 0 || (info[2] & (1 << 28)) == 0)
+		return false;
+	if ((_xgetbv(0) & 6) != 6)
+		return false;
+
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1 << 5)) != 0;
+#else
+	return false;
+#endif
+}
+#endif
+
+// Selects the classifier supported by the CPU
+static ClassifyFunc selectClassifier(void)
+{
+#ifdef STRUCTURAL_AVX2
+	if (cpuHasAvx2())
+		return &classifyAvx2;
+#endif
+
+#ifdef CJPATH_SSE2
+	return &classifySse2;
+#else
+	return &classifyScalar;
+#endif
+}
+
+// Returns the mask of symbols escaped by backslash, carry is the escape of the first symbol of the next block
+static uint64_t findEscaped(uint64_t backslash, uint64_t* carry)
+{
+	uint64_t escaped;
+	uint64_t bit;
+
+	escaped = *carry;
+	*carry = 0;
+
+	// The escaped backslash does not escape the next symbol
+	for (backslash &= ~escaped; backslash != 0; backslash &= backslash - 1)
+	{
+		bit = backslash & (~backslash + 1);
+		if (escaped & bit)
+			continue;
+
+		if (bit == ((uint64_t)1 << 63))
+			*carry = 1;
+		else
+			escaped |= bit << 1;
+	}
+
+	return escaped;
+}
+
+// Each bit is set if odd number of quotes is before or at the position
+static uint64_t prefixXor(uint64_t value)
+{
+	value ^= value << 1;
+	value ^= value << 2;
+	value ^= value << 4;
+	value ^= value << 8;
+	value ^= value << 16;
+	value ^= value << 32;
+
+	return value;
+}
+
+static bool growPositions(CJPathStructuralIndex* index, MemAllocFunc memAllocFunc, MemFreeFunc memFreeFunc)
+{
+	uint32_t* positions;
+
+	positions = (uint32_t*)memAllocFunc(index->positionsCapacity * 2 * sizeof(uint32_t));
+	if (positions == NULL)
+		return false;
+
+	memcpy(positions, index->positions, index->count * sizeof(uint32_t));
+	memFreeFunc(index->positions);
+
+	index->positions = positions;
+	index->positionsCapacity *= 2;
+
+	return true;
+}
+
+// Pairs brackets, the stack of open brackets is linked through the pairs array
+static void pairBrackets(CJPathStructuralIndex* index)
+{
+	size_t i;
+	uint32_t top, open;
+	char symbol;
+
+	for (i = 0, top = STRUCTURAL_NO_PAIR; i < index->count; ++i)
+	{
+		symbol = index->jsonData[index->positions[i]];
+
+		if (symbol == '{' || symbol == '[')
+		{
+			index->pairs[i] = top;
+			top = (uint32_t)i;
+		}
+		else if (symbol == '}' || symbol == ']')
+		{
+			if (top == STRUCTURAL_NO_PAIR)
+			{
+				index->pairs[i] = STRUCTURAL_NO_PAIR;
+				continue;
+			}
+
+			open = top;
+			top = index->pairs[open];
+			index->pairs[open] = (uint32_t)i;
+			index->pairs[i] = open;
+		}
+		else
+			index->pairs[i] = STRUCTURAL_NO_PAIR;
+	}
+
+	// Not closed brackets
+	while (top != STRUCTURAL_NO_PAIR)
+	{
+		open = top;
+		top = index->pairs[open];
+		index->pairs[open] = STRUCTURAL_NO_PAIR;
+	}
+}
+
+// Finds the position in the index
+static bool findPosition(const CJPathStructuralIndex* index, const char* ptr, size_t* idx)
+{
+	size_t offset, lo, hi, mid;
+
+	if (ptr < index->jsonData || ptr >= index->jsonData + index->jsonDataLen)
+		return false;
+
+	offset = (size_t)(ptr - index->jsonData);
+
+	for (lo = 0, hi = index->count; lo < hi;)
+	{
+		mid = lo + (hi - lo) / 2;
+		if (index->positions[mid] < offset)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	if (lo == index->count || index->positions[lo] != offset)
+		return false;
+
+	*idx = lo;
+	return true;
+}
+
+const char* structuralSkipContainer(const CJPathStructuralIndex* index, const char* ptr, const char* end, bool* found)
+{
+	size_t idx;
+	const char* ptrEnd;
+
+	*found = findPosition(index, ptr, &idx);
+	if (!*found)
+		return NULL;
+
+	if (index->pairs[idx] == STRUCTURAL_NO_PAIR)
+		return NULL;
+
+	ptrEnd = index->jsonData + index->positions[index->pairs[idx]] + 1;
+
+	return (ptrEnd <= end) ? ptrEnd : NULL;
+}
+
+const char* structuralSkipString(const CJPathStructuralIndex* index, const char* ptr, const char* end, bool* found)
+{
+	size_t idx;
+	const char* ptrEnd;
+
+	*found = findPosition(index, ptr, &idx);
+	if (!*found)
+		return NULL;
+
+	// Inside the string there are no structural symbols, so the next one is the closing quote
+	if (idx + 1 == index->count || index->jsonData[index->positions[idx + 1]] != '"')
+		return NULL;
+
+	ptrEnd = index->jsonData + index->positions[idx + 1] + 1;
+
+	return (ptrEnd <= end) ? ptrEnd : NULL;
+}
+
+CJPathStatus fillStructuralIndex(CJPathStructuralIndex* index, const char* jsonData, size_t jsonDataLen,
+	MemAllocFunc memAllocFunc, MemFreeFunc memFreeFunc)
+{
+	ClassifyFunc classify;
+	BlockMasks masks;
+	char lastBlock[BLOCK_SIZE];
+	const char* block;
+	size_t offset, capacity;
+	uint64_t escaped, escapeCarry, quotes, inString, stringCarry, bits;
+
+	// Offsets are stored in 32 bits
+	if (jsonDataLen >= STRUCTURAL_NO_PAIR)
+		return INVALID_ARGUMENT;
+
+	index->jsonData = jsonData;
+	index->jsonDataLen = jsonDataLen;
+	index->count = 0;
+
+	capacity = jsonDataLen / 8 + BLOCK_SIZE;
+	if (index->positionsCapacity < capacity)
+	{
+		if (index->positions != NULL)
+			memFreeFunc(index->positions);
+
+		index->positions = (uint32_t*)memAllocFunc(capacity * sizeof(uint32_t));
+		index->positionsCapacity = (index->positions != NULL) ? capacity : 0;
+		if (index->positions == NULL)
+			return BAD_ALLOC;
+	}
+
+	classify = selectClassifier();
+
+	for (offset = 0, escapeCarry = 0, stringCarry = 0; offset < jsonDataLen; offset += BLOCK_SIZE)
+	{
+		// The last block is padded with spaces
+		if (jsonDataLen - offset < BLOCK_SIZE)
+		{
+			memset(lastBlock, ' ', sizeof(lastBlock));
+			memcpy(lastBlock, jsonData + offset, jsonDataLen - offset);
+			block = lastBlock;
+		}
+		else
+			block = jsonData + offset;
+
+		classify(block, &masks);
+
+		escaped = findEscaped(masks.backslash, &escapeCarry);
+		quotes = masks.quote & ~escaped;
+
+		// Opening quote is inside the string, closing one is not
+		inString = prefixXor(quotes) ^ stringCarry;
+		stringCarry = (inString >> 63) ? ~(uint64_t)0 : 0;
+
+		bits = (masks.structural & ~inString) | quotes;
+
+		if (index->count + BLOCK_SIZE > index->positionsCapacity && !growPositions(index, memAllocFunc, memFreeFunc))
+			return BAD_ALLOC;
+
+		for (; bits != 0; bits &= bits - 1)
+			index->positions[index->count++] = (uint32_t)(offset + countTrailingZeros(bits));
+	}
+
+	if (index->pairsCapacity < index->count + 1)
+	{
+		if (index->pairs != NULL)
+			memFreeFunc(index->pairs);
+
+		index->pairs = (uint32_t*)memAllocFunc((index->count + 1) * sizeof(uint32_t));
+		index->pairsCapacity = (index->pairs != NULL) ? index->count + 1 : 0;
+		if (index->pairs == NULL)
+			return BAD_ALLOC;
+	}
+
+	pairBrackets(index);
+
+	return SUCCESS;
+}
+
+CJPathStatus CJPathBuildStructuralIndex(const char* jsonData, size_t jsonDataLen, CJPathStructuralIndex** index,
+	MemAllocFunc memAllocFunc, MemFreeFunc memFreeFunc)
+{
+	CJPathStatus status;
+	CJPathStructuralIndex* ptr;
+
+	if (jsonData == NULL || index == NULL || memAllocFunc == NULL || memFreeFunc == NULL)
+		return INVALID_ARGUMENT;
+
+	*index = NULL;
+
+	ptr = (CJPathStructuralIndex*)memAllocFunc(sizeof(CJPathStructuralIndex));
+	if (ptr == NULL)
+		return BAD_ALLOC;
+	memset(ptr, 0, sizeof(*ptr));
+
+	status = fillStructuralIndex(ptr, jsonData, jsonDataLen, memAllocFunc, memFreeFunc);
+	if (status != SUCCESS)
+	{
+		CJPathFreeStructuralIndex(&ptr, memFreeFunc);
+		return status;
+	}
+
+	*index = ptr;
+
+	return SUCCESS;
+}
+
+void CJPathFreeStructuralIndex(CJPathStructuralIndex** index, MemFreeFunc memFreeFunc)
+{
+	if (index == NULL || *index == NULL)
+		return;
+
+	if ((*index)->positions != NULL)
+		memFreeFunc((*index)->positions);
+	if ((*index)->pairs != NULL)
+		memFreeFunc((*index)->pairs);
+	memFreeFunc(*index);
+
+	*index = NULL;
+}
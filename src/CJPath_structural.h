@@ -0,0 +1,33 @@
+#ifndef _CJPATH_STRUCTURAL_H
+#define _CJPATH_STRUCTURAL_H
+
+#include "CJPath.h"
+#include <stdint.h>
+
+#define STRUCTURAL_NO_PAIR UINT32_MAX
+
+struct _CJPathStructuralIndex
+{
+	const char* jsonData;
+	size_t jsonDataLen;
+
+	// Offsets of { } [ ] : , and quotes outside strings
+	size_t count;
+	uint32_t* positions;
+
+	// For brackets, index of the paired bracket (or STRUCTURAL_NO_PAIR)
+	uint32_t* pairs;
+
+	// Allocated items, kept when the index is filled again
+	size_t positionsCapacity;
+	size_t pairsCapacity;
+};
+
+// Indexes the JSON, the arrays of the previous JSON are reused if they are large enough
+CJPathStatus fillStructuralIndex(CJPathStructuralIndex* index, const char* jsonData, size_t jsonDataLen,
+	MemAllocFunc memAllocFunc, MemFreeFunc memFreeFunc);
+
+const char* structuralSkipContainer(const CJPathStructuralIndex* index, const char* ptr, const char* end, bool* found);
+const char* structuralSkipString(const CJPathStructuralIndex* index, const char* ptr, const char* end, bool* found);
+
+#endif // _CJPATH_STRUCTURAL_H
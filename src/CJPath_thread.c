@@ -0,0 +1,158 @@
+#include "CJPath_thread.h"
+
+#if defined(CJPATH_WIN32_THREADS)
+
+static DWORD WINAPI threadEntry(LPVOID param)
+{
+	CJPathThread* const thread = (CJPathThread*)param;
+
+	thread->func(thread->arg);
+
+	return 0;
+}
+
+bool threadStart(CJPathThread* thread, ThreadFunc func, void* arg)
+{
+	thread->func = func;
+	thread->arg = arg;
+	thread->handle = CreateThread(NULL, 0, &threadEntry, thread, 0, NULL);
+
+	return (thread->handle != NULL);
+}
+
+void threadJoin(CJPathThread* thread)
+{
+	WaitForSingleObject(thread->handle, INFINITE);
+	CloseHandle(thread->handle);
+}
+
+void mutexInit(CJPathMutex* mutex)
+{
+	InitializeCriticalSection(&mutex->handle);
+}
+
+void mutexLock(CJPathMutex* mutex)
+{
+	EnterCriticalSection(&mutex->handle);
+}
+
+void mutexUnlock(CJPathMutex* mutex)
+{
+	LeaveCriticalSection(&mutex->handle);
+}
+
+void mutexDestroy(CJPathMutex* mutex)
+{
+	DeleteCriticalSection(&mutex->handle);
+}
+
+static BOOL CALLBACK onceEntry(PINIT_ONCE once, PVOID param, PVOID* context)
+{
+	(void)once;
+	(void)context;
+
+	(*(OnceFunc*)param)();
+
+	return TRUE;
+}
+
+void threadOnce(CJPathOnce* once, OnceFunc func)
+{
+	InitOnceExecuteOnce(&once->handle, &onceEntry, &func, NULL);
+}
+
+#elif defined(CJPATH_PTHREADS)
+
+static void* threadEntry(void* param)
+{
+	CJPathThread* const thread = (CJPathThread*)param;
+
+	thread->func(thread->arg);
+
+	return NULL;
+}
+
+bool threadStart(CJPathThread* thread, ThreadFunc func, void* arg)
+{
+	thread->func = func;
+	thread->arg = arg;
+
+	return (pthread_create(&thread->handle, NULL, &threadEntry, thread) == 0);
+}
+
+void threadJoin(CJPathThread* thread)
+{
+	pthread_join(thread->handle, NULL);
+}
+
+void mutexInit(CJPathMutex* mutex)
+{
+	pthread_mutex_init(&mutex->handle, NULL);
+}
+
+void mutexLock(CJPathMutex* mutex)
+{
+	pthread_mutex_lock(&mutex->handle);
+}
+
+void mutexUnlock(CJPathMutex* mutex)
+{
+	pthread_mutex_unlock(&mutex->handle);
+}
+
+void mutexDestroy(CJPathMutex* mutex)
+{
+	pthread_mutex_destroy(&mutex->handle);
+}
+
+void threadOnce(CJPathOnce* once, OnceFunc func)
+{
+	pthread_once(&once->handle, func);
+}
+
+#else
+
+bool threadStart(CJPathThread* thread, ThreadFunc func, void* arg)
+{
+	(void)thread;
+	(void)func;
+	(void)arg;
+
+	return false;
+}
+
+void threadJoin(CJPathThread* thread)
+{
+	(void)thread;
+}
+
+void mutexInit(CJPathMutex* mutex)
+{
+	(void)mutex;
+}
+
+void mutexLock(CJPathMutex* mutex)
+{
+	(void)mutex;
+}
+
+void mutexUnlock(CJPathMutex* mutex)
+{
+	(void)mutex;
+}
+
+void mutexDestroy(CJPathMutex* mutex)
+{
+	(void)mutex;
+}
+
+void threadOnce(CJPathOnce* once, OnceFunc func)
+{
+	if (!once->done)
+	{
+		once->done = true;
+		func();
+	}
+}
+
+#endif
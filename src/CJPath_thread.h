@@ -0,0 +1,74 @@
+#ifndef _CJPATH_THREAD_H
+#define _CJPATH_THREAD_H
+
+#include <stdbool.h>
+
+#if !defined(CJPATH_NO_THREADS) && defined(_WIN32)
+#define CJPATH_WIN32_THREADS
+#include <windows.h>
+#elif !defined(CJPATH_NO_THREADS)
+#define CJPATH_PTHREADS
+#include <pthread.h>
+#endif
+
+typedef void (*ThreadFunc)(void* arg);
+typedef void (*OnceFunc)(void);
+
+// Worker thread, the structure must not be moved while the thread is running
+typedef struct
+{
+	ThreadFunc func;
+	void* arg;
+
+#if defined(CJPATH_WIN32_THREADS)
+	HANDLE handle;
+#elif defined(CJPATH_PTHREADS)
+	pthread_t handle;
+#endif
+} CJPathThread;
+
+// Lock shared by the worker threads, no-op without threads
+typedef struct
+{
+#if defined(CJPATH_WIN32_THREADS)
+	CRITICAL_SECTION handle;
+#elif defined(CJPATH_PTHREADS)
+	pthread_mutex_t handle;
+#else
+	int unused;
+#endif
+} CJPathMutex;
+
+// One-time initialization, set to CJPATH_ONCE_INIT
+typedef struct
+{
+#if defined(CJPATH_WIN32_THREADS)
+	INIT_ONCE handle;
+#elif defined(CJPATH_PTHREADS)
+	pthread_once_t handle;
+#else
+	bool done;
+#endif
+} CJPathOnce;
+
+#if defined(CJPATH_WIN32_THREADS)
+#define CJPATH_ONCE_INIT { INIT_ONCE_STATIC_INIT }
+#elif defined(CJPATH_PTHREADS)
+#define CJPATH_ONCE_INIT { PTHREAD_ONCE_INIT }
+#else
+#define CJPATH_ONCE_INIT { false }
+#endif
+
+// Starts func(arg) in a new thread, returns false if threads are not available
+bool threadStart(CJPathThread* thread, ThreadFunc func, void* arg);
+void threadJoin(CJPathThread* thread);
+
+void mutexInit(CJPathMutex* mutex);
+void mutexLock(CJPathMutex* mutex);
+void mutexUnlock(CJPathMutex* mutex);
+void mutexDestroy(CJPathMutex* mutex);
+
+// Calls func once, the other callers wait until it returns
+void threadOnce(CJPathOnce* once, OnceFunc func);
+
+#endif // _CJPATH_THREAD_H
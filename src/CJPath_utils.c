@@ -1,22 +1,28 @@
 #include "CJPath_utils.h"
+#include "CJPath_stats.h"
 #include <string.h>
 
-char* strnstr(const char* searchString, const char* inputString, size_t inputStringLen)
-{
-	size_t searchStrLen;
-	size_t idx;
-
-	searchStrLen = strlen(searchString);
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
 
-	if (inputStringLen >= searchStrLen)
-	{
-		for (idx = 0; idx < inputStringLen - searchStrLen; ++idx)
-		{
-			if (strncmp(searchString, inputString + idx, searchStrLen) == 0)
-				return (char*) inputString + idx; // Found -> ret entry
-		}
-	}
+char* strnchr(char searchChar, const char* inputString, size_t inputStringLen)
+{
+	STATS_ADD(charSearches, 1);
+	return (char*)memchr(inputString, searchChar, inputStringLen);
+}
 
-	// Not found
-	return NULL;
+unsigned countTrailingZeros(uint64_t value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+	return (unsigned)__builtin_ctzll(value);
+#elif defined(_MSC_VER) && defined(_M_X64)
+	unsigned long idx;
+	_BitScanForward64(&idx, value);
+	return (unsigned)idx;
+#else
+	unsigned idx;
+	for (idx = 0; !(value & 1); value >>= 1, ++idx);
+	return idx;
+#endif
 }
\ No newline at end of file
@@ -2,7 +2,14 @@
 #define _CJPATH_UTILS_H
 
 #include <stdio.h>
+#include <stdint.h>
 
-char* strnstr(const char* searchStr, const char* str, size_t strLen);
+#if !defined(CJPATH_NO_SIMD) && (defined(__x86_64__) || defined(_M_X64))
+#define CJPATH_SSE2
+#endif
+
+char* strnchr(char searchChar, const char* str, size_t strLen);
+
+unsigned countTrailingZeros(uint64_t value);
 
 #endif // _CJPATH_UTILS_H
\ No newline at end of file
@@ -0,0 +1,433 @@
+#if !defined(_WIN32) && !defined(_GNU_SOURCE)
+// strtod_l of glibc
+#define _GNU_SOURCE
+#endif
+
+#include "CJPath_internal.h"
+#include "CJPath_thread.h"
+#include <locale.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__APPLE__) || defined(__FreeBSD__)
+#include <xlocale.h>
+#endif
+
+// Max length of the number converted by strtod
+#define NUMBER_MAX_LEN 1023
+
+// Max number of the mantissa digits collected without loss
+#define MANTISSA_MAX_DIGITS 19
+
+// Max mantissa represented exactly by double
+#define EXACT_MANTISSA_MAX ((uint64_t)1 << 53)
+
+// Powers of ten represented exactly by double
+static const double exactPowers[] = {
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+// Decimal number: value = mantissa * 10^exponent
+typedef struct
+{
+	bool negative;
+	uint64_t mantissa;
+	long exponent;
+
+	// Nonzero digits are dropped from the mantissa
+	bool truncated;
+} DecimalNumber;
+
+// Appends the digit to the mantissa, the digits after the first 19 significant ones are dropped
+static void addDigit(DecimalNumber* number, int digit, bool fraction, int* digits)
+{
+	if (*digits < MANTISSA_MAX_DIGITS)
+	{
+		number->mantissa = number->mantissa * 10 + (uint64_t)digit;
+		if (number->mantissa != 0)
+			++(*digits);
+		if (fraction)
+			--number->exponent;
+	}
+	else
+	{
+		number->truncated = number->truncated || digit != 0;
+		if (!fraction)
+			++number->exponent;
+	}
+}
+
+// Checks the JSON number syntax and collects the mantissa and the exponent
+static bool parseDecimal(const char* ptr, const char* end, DecimalNumber* number)
+{
+	bool negativeExponent;
+	long exponent;
+	int digits;
+
+	memset(number, 0, sizeof(*number));
+	digits = 0;
+
+	if (ptr != end && ptr[0] == '-')
+	{
+		number->negative = true;
+		++ptr;
+	}
+
+	if (ptr == end || !charIsIntegerNum(ptr[0]))
+		return false;
+
+	// Leading zeros are not allowed
+	if (ptr[0] == '0')
+		++ptr;
+	else
+	{
+		for (; ptr != end && charIsIntegerNum(ptr[0]); ++ptr)
+			addDigit(number, ptr[0] - '0', false, &digits);
+	}
+
+	if (ptr != end && ptr[0] == '.')
+	{
+		++ptr; // by pass .
+		if (ptr == end || !charIsIntegerNum(ptr[0]))
+			return false;
+
+		for (; ptr != end && charIsIntegerNum(ptr[0]); ++ptr)
+			addDigit(number, ptr[0] - '0', true, &digits);
+	}
+
+	if (ptr != end && (ptr[0] == 'e' || ptr[0] == 'E'))
+	{
+		++ptr; // by pass e
+		negativeExponent = (ptr != end && ptr[0] == '-');
+		if (ptr != end && (ptr[0] == '-' || ptr[0] == '+'))
+			++ptr;
+
+		if (ptr == end || !charIsIntegerNum(ptr[0]))
+			return false;
+
+		// The exponent is limited, the value is zero or infinity long before the limit
+		for (exponent = 0; ptr != end && charIsIntegerNum(ptr[0]); ++ptr)
+		{
+			if (exponent < 100000)
+				exponent = exponent * 10 + (ptr[0] - '0');
+		}
+
+		number->exponent += negativeExponent ? -exponent : exponent;
+	}
+
+	return (ptr == end);
+}
+
+// strtod reads the decimal point of the locale (example: 1,5 in de_DE), so the JSON point is replaced by it
+
+CJPathValueType CJPathResultType(const CJPathResult* result)
+{
+	if (result == NULL || result->strPtr == NULL || result->strLen == 0)
+		return TYPE_INVALID;
+
+	switch (result->strPtr[0])
+	{
+	case '"': return TYPE_STRING;
+	case '{': return TYPE_OBJECT;
+	case '[': return TYPE_ARRAY;
+	case 't':
+	case 'f': return TYPE_BOOL;
+	case 'n': return TYPE_NULL;
+	default:  return charIsNumberStart(result->strPtr[0]) ? TYPE_NUMBER : TYPE_INVALID;
+	}
+}
+
+CJPathStatus CJPathGetInt64(const CJPathResult* result, int64_t* value)
+{
+	const char* ptr;
+	const char* end;
+	uint64_t magnitude, limit;
+	bool negative;
+
+	if (result == NULL || result->strPtr == NULL || value == NULL)
+		return INVALID_ARGUMENT;
+
+	ptr = result->strPtr;
+	end = ptr + result->strLen;
+
+	negative = (ptr != end && ptr[0] == '-');
+	if (negative)
+		++ptr;
+
+	if (ptr == end || !charIsIntegerNum(ptr[0]) || (ptr[0] == '0' && end - ptr > 1))
+		return INVALID_TYPE;
+
+	limit = negative ? (uint64_t)INT64_MAX + 1 : (uint64_t)INT64_MAX;
+
+	for (magnitude = 0; ptr != end; ++ptr)
+	{
+		if (!charIsIntegerNum(ptr[0]) || magnitude > (limit - (uint64_t)(ptr[0] - '0')) / 10)
+			return INVALID_TYPE;
+
+		magnitude = magnitude * 10 + (uint64_t)(ptr[0] - '0');
+	}
+
+	*value = negative ? (int64_t)(0 - magnitude) : (int64_t)magnitude;
+	return SUCCESS;
+}
+
+// "C" locale of the numbers converted by strtod, created once for all threads
+#if defined(_WIN32)
+static _locale_t numericLocale;
+#else
+static locale_t numericLocale;
+#endif
+
+static CJPathOnce numericLocaleOnce = CJPATH_ONCE_INIT;
+
+static void createNumericLocale(void)
+{
+#if defined(_WIN32)
+	numericLocale = _create_locale(LC_NUMERIC, "C");
+#else
+	numericLocale = newlocale(LC_NUMERIC_MASK, "C", (locale_t)0);
+#endif
+}
+
+// Converts the number that is not exact in double, independently of the process locale
+static bool convertInexact(const char* ptr, size_t len, double* value)
+{
+	char buf[NUMBER_MAX_LEN + 1];
+	char* bufEnd;
+
+	if (len > NUMBER_MAX_LEN)
+		return false;
+
+	threadOnce(&numericLocaleOnce, &createNumericLocale);
+	if (!numericLocale)
+		return false;
+
+	memcpy(buf, ptr, len);
+	buf[len] = '\0';
+
+#if defined(_WIN32)
+	*value = _strtod_l(buf, &bufEnd, numericLocale);
+#else
+	*value = strtod_l(buf, &bufEnd, numericLocale);
+#endif
+
+	return (bufEnd == buf + len);
+}
+
+bool numberToDouble(const char* ptr, size_t len, double* value)
+{
+	DecimalNumber number;
+	double converted;
+
+	if (!parseDecimal(ptr, ptr + len, &number))
+		return false;
+
+	// Both the mantissa and the power of ten are exact, so the single rounding gives the exact result
+	if (!number.truncated && number.mantissa <= EXACT_MANTISSA_MAX && number.exponent >= -22 && number.exponent <= 22)
+	{
+		converted = (double)number.mantissa;
+		converted = (number.exponent < 0) ? converted / exactPowers[-number.exponent] : converted * exactPowers[number.exponent];
+
+		*value = number.negative ? -converted : converted;
+		return true;
+	}
+
+	return convertInexact(ptr, len, value);
+}
+
+CJPathStatus CJPathGetDouble(const CJPathResult* result, double* value)
+{
+	double converted;
+
+	if (result == NULL || result->strPtr == NULL || value == NULL)
+		return INVALID_ARGUMENT;
+
+	if (!numberToDouble(result->strPtr, result->strLen, &converted) || converted == HUGE_VAL || converted == -HUGE_VAL)
+		return INVALID_TYPE;
+
+	*value = converted;
+	return SUCCESS;
+}
+
+CJPathStatus CJPathGetBool(const CJPathResult* result, bool* value)
+{
+	if (result == NULL || result->strPtr == NULL || value == NULL)
+		return INVALID_ARGUMENT;
+
+	if (result->strLen == JSON_VALUE_TRUE_LEN && memcmp(result->strPtr, JSON_VALUE_TRUE, JSON_VALUE_TRUE_LEN) == 0)
+		*value = true;
+	else if (result->strLen == JSON_VALUE_FALSE_LEN && memcmp(result->strPtr, JSON_VALUE_FALSE, JSON_VALUE_FALSE_LEN) == 0)
+		*value = false;
+	else
+		return INVALID_TYPE;
+
+	return SUCCESS;
+}
+
+// Reads 4 hex digits of \u
+static bool parseHex4(const char* ptr, const char* end, unsigned* code)
+{
+	int i;
+
+	if (end - ptr < 4)
+		return false;
+
+	for (i = 0, *code = 0; i < 4; ++i)
+	{
+		*code <<= 4;
+		if (ptr[i] >= '0' && ptr[i] <= '9')
+			*code |= (unsigned)(ptr[i] - '0');
+		else if (ptr[i] >= 'a' && ptr[i] <= 'f')
+			*code |= (unsigned)(ptr[i] - 'a' + 10);
+		else if (ptr[i] >= 'A' && ptr[i] <= 'F')
+			*code |= (unsigned)(ptr[i] - 'A' + 10);
+		else
+			return false;
+	}
+
+	return true;
+}
+
+// Writes the code point as UTF-8, returns the number of bytes. If out is NULL, only the length is returned.
+static size_t encodeUtf8(unsigned code, char* out)
+{
+	char bytes[4];
+	size_t len;
+
+	if (code < 0x80)
+	{
+		bytes[0] = (char)code;
+		len = 1;
+	}
+	else if (code < 0x800)
+	{
+		bytes[0] = (char)(0xC0 | (code >> 6));
+		bytes[1] = (char)(0x80 | (code & 0x3F));
+		len = 2;
+	}
+	else if (code < 0x10000)
+	{
+		bytes[0] = (char)(0xE0 | (code >> 12));
+		bytes[1] = (char)(0x80 | ((code >> 6) & 0x3F));
+		bytes[2] = (char)(0x80 | (code & 0x3F));
+		len = 3;
+	}
+	else
+	{
+		bytes[0] = (char)(0xF0 | (code >> 18));
+		bytes[1] = (char)(0x80 | ((code >> 12) & 0x3F));
+		bytes[2] = (char)(0x80 | ((code >> 6) & 0x3F));
+		bytes[3] = (char)(0x80 | (code & 0x3F));
+		len = 4;
+	}
+
+	if (out != NULL)
+		memcpy(out, bytes, len);
+
+	return len;
+}
+
+// Decodes the escape after \, the pointer is moved after the escape. If out is NULL, only the length is returned.
+static bool decodeEscape(const char** ptr, const char* end, char* out, size_t* len)
+{
+	static const char escapes[] = "\"\"\\\\//b\bf\fn\nr\rt\t";
+	unsigned code, low;
+	size_t i;
+
+	if (*ptr == end)
+		return false;
+
+	if ((*ptr)[0] != 'u')
+	{
+		for (i = 0; escapes[i] != '\0'; i += 2)
+		{
+			if (escapes[i] == (*ptr)[0])
+			{
+				if (out != NULL)
+					out[0] = escapes[i + 1];
+				*len = 1;
+				++(*ptr);
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	if (!parseHex4(*ptr + 1, end, &code))
+		return false;
+	*ptr += 5; // by pass uXXXX
+
+	// The surrogate pair is one code point
+	if (code >= 0xD800 && code <= 0xDBFF)
+	{
+		if (end - *ptr < 6 || (*ptr)[0] != '\\' || (*ptr)[1] != 'u' || !parseHex4(*ptr + 2, end, &low)
+			|| low < 0xDC00 || low > 0xDFFF)
+			return false;
+
+		code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+		*ptr += 6; // by pass \uXXXX
+	}
+	else if (code >= 0xDC00 && code <= 0xDFFF)
+		return false;
+
+	*len = encodeUtf8(code, out);
+	return true;
+}
+
+// Decodes the text between the quotes. If out is NULL, only the length is counted.
+static bool decodeString(const char* ptr, const char* end, char* out, size_t* textLen)
+{
+	const char* escape;
+	size_t len;
+
+	for (*textLen = 0; ptr != end; )
+	{
+		// The text up to the escape is copied as is
+		escape = (const char*)memchr(ptr, '\\', (size_t)(end - ptr));
+		len = (size_t)(((escape != NULL) ? escape : end) - ptr);
+
+		if (out != NULL)
+			memcpy(out + *textLen, ptr, len);
+		*textLen += len;
+		ptr += len;
+
+		if (escape == NULL)
+			break;
+
+		++ptr; // by pass backslash
+		if (!decodeEscape(&ptr, end, (out != NULL) ? out + *textLen : NULL, &len))
+			return false;
+		*textLen += len;
+	}
+
+	return true;
+}
+
+CJPathStatus CJPathUnescapeInto(const CJPathResult* result, char* buffer, size_t bufferSize, size_t* textLen)
+{
+	const char* start;
+	const char* end;
+
+	if (result == NULL || result->strPtr == NULL || textLen == NULL || (buffer == NULL && bufferSize != 0))
+		return INVALID_ARGUMENT;
+
+	if (result->strLen < 2 || result->strPtr[0] != '"' || result->strPtr[result->strLen - 1] != '"')
+		return INVALID_TYPE;
+
+	start = result->strPtr + 1;
+	end = result->strPtr + result->strLen - 1;
+
+	if (!decodeString(start, end, NULL, textLen))
+		return INVALID_JSON;
+
+	if (*textLen + 1 > bufferSize)
+		return BUFFER_TOO_SMALL;
+
+	decodeString(start, end, buffer, textLen);
+	buffer[*textLen] = '\0';
+
+	return SUCCESS;
+}